@@ -0,0 +1,128 @@
+`timescale 1ns / 1ps
+
+// One layer of the Benes network used by McEliece, applied to a 64x64 bit matrix kept inside the unit.
+// The matrix is streamed through out0 and replaced by in0 as 128 words (row i is word 2*i for the low half and 2*i+1 for the high half).
+// A layer consumes 64 words of condition bits from in0, in the same order they are stored in the secret key:
+//  - row layer: word 2*k (2*k+1) masks the swap of the low (high) halves of the k-th pair of rows at distance 2^lgs
+//  - column layer: word i selects which of the 32 pairs of bits at distance 2^lgs are swapped inside row i
+// Column layers are the layers that the software applies to the transposed matrix, so no transposition is needed.
+// When enable is not set the unit finishes immediately, so that it does not lengthen the runs of other algorithms.
+module BenesLayer #(
+         parameter DELAY_W = 7,
+         parameter DATA_W = 32
+              )
+    (
+    //control
+    input               clk,
+    input               rst,
+
+    input               running,
+    input               run,
+    output              done,
+
+    //input / output data
+    input [DATA_W-1:0]  in0,
+
+    (* versat_latency = 1 *) output reg [DATA_W-1:0] out0,
+
+    //configurations
+    input               enable, // Stream the matrix this run
+    input               load,   // Replace the matrix with the 128 words received, while streaming the old one
+    input               apply,  // Apply a layer with the 64 words received
+    input               column, // Column layer instead of row layer
+    input [2:0]         lgs,    // Swap distance is 2^lgs
+
+    input [DELAY_W-1:0] delay0 // Encodes delay
+    );
+
+reg [DELAY_W-1:0] delay;
+reg [6:0] index;
+reg busy;
+
+reg [63:0] M[63:0];
+
+assign done = !busy;
+
+// Runs that apply a layer only need the 64 condition words, the others stream the full matrix
+wire [6:0] lastIndex = (!load && apply) ? 7'd63 : 7'd127;
+
+wire [5:0] s = 6'd1 << lgs;
+
+// First row of the k-th pair at distance s, pairs being numbered in the order the software layer visits them
+function [5:0] PAIR_FIRST(input [4:0] k,input [2:0] lgs);
+begin
+   PAIR_FIRST = (({1'b0,k} >> lgs) << (lgs + 1)) | ({1'b0,k} & ((6'd1 << lgs) - 6'd1));
+end
+endfunction
+
+// Places condition bit k at the position of the first bit of the k-th pair
+function [63:0] SPREAD(input [31:0] c,input [2:0] lgs);
+integer k;
+begin
+   SPREAD = 64'h0;
+   for(k = 0; k < 32; k = k + 1) begin
+      SPREAD[PAIR_FIRST(k,lgs)] = c[k];
+   end
+end
+endfunction
+
+// Row layer
+wire [5:0] first = PAIR_FIRST(index[5:1],lgs);
+wire [31:0] rowA = index[0] ? M[first][63:32] : M[first][31:0];
+wire [31:0] rowB = index[0] ? M[first + s][63:32] : M[first + s][31:0];
+wire [31:0] rowD = (rowA ^ rowB) & in0;
+
+// Column layer
+wire [63:0] colRow = M[index[5:0]];
+wire [63:0] colD = (colRow ^ (colRow >> s)) & SPREAD(in0,lgs);
+wire [63:0] colNew = colRow ^ colD ^ (colD << s);
+
+wire [63:0] lane = M[index[6:1]];
+
+integer i;
+always @(posedge clk,posedge rst)
+begin
+   if(rst) begin
+      delay <= 0;
+      index <= 0;
+      busy <= 0;
+      out0 <= 0;
+      for(i = 0; i < 64; i = i + 1)
+         M[i] <= 0;
+   end else if(run) begin
+      delay <= delay0; // wait delay0 cycles for valid input data
+      index <= 0;
+      busy <= enable;
+   end else if(busy) begin
+      if(|delay) begin
+         delay <= delay - 1;
+      end else begin
+         out0 <= index[0] ? lane[63:32] : lane[31:0];
+
+         if(load) begin
+            if(index[0])
+               M[index[6:1]][63:32] <= in0;
+            else
+               M[index[6:1]][31:0] <= in0;
+         end else if(apply) begin
+            if(column) begin
+               M[index[5:0]] <= colNew;
+            end else if(index[0]) begin
+               M[first][63:32] <= rowA ^ rowD;
+               M[first + s][63:32] <= rowB ^ rowD;
+            end else begin
+               M[first][31:0] <= rowA ^ rowD;
+               M[first + s][31:0] <= rowB ^ rowD;
+            end
+         end
+
+         index <= index + 1;
+
+         if(index == lastIndex) begin
+            busy <= 0;
+         end
+      end
+   end
+end
+
+endmodule
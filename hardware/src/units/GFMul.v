@@ -0,0 +1,67 @@
+`timescale 1ns / 1ps
+
+// Multiplies the two field elements of a word (bits 15:0 and 31:16) by the scalar configuration.
+// The field is GF(2^12) modulo x^12 + x^3 + 1, or GF(2^13) modulo x^13 + x^4 + x^3 + x + 1 when gf13 is set,
+// the fields used by the McEliece parameter sets. The unused high bits of each half are output as zero.
+module GFMul #(
+         parameter DATA_W = 32
+              )
+    (
+    //control
+    input               clk,
+    input               rst,
+
+    input               running,
+    input               run,
+    output              done,
+
+    //input / output data
+    input [DATA_W-1:0]  in0,
+
+    (* versat_latency = 1 *) output reg [DATA_W-1:0] out0,
+
+    //configurations
+    input [12:0]        scalar,
+    input               gf13
+    );
+
+// Carry-less product followed by the reduction of the bits above the field size, from the highest one down
+function [12:0] GF_MUL(input [12:0] a,input [12:0] b,input gf13);
+integer i;
+reg [24:0] p;
+begin
+   p = 25'h0;
+   for(i = 0; i < 13; i = i + 1) begin
+      if(b[i]) begin
+         p = p ^ ({12'h0,a} << i);
+      end
+   end
+
+   for(i = 24; i >= 12; i = i - 1) begin
+      if(gf13) begin
+         if(i >= 13 && p[i]) begin
+            p = p ^ (25'h201B << (i - 13));
+         end
+      end else if(p[i]) begin
+         p = p ^ (25'h1009 << (i - 12));
+      end
+   end
+
+   GF_MUL = p[12:0];
+end
+endfunction
+
+assign done = 1'b1;
+
+wire [12:0] mask = gf13 ? 13'h1FFF : 13'h0FFF;
+
+always @(posedge clk,posedge rst)
+begin
+   if(rst) begin
+      out0 <= 0;
+   end else begin
+      out0 <= {3'h0,GF_MUL(in0[28:16] & mask,scalar & mask,gf13),3'h0,GF_MUL(in0[12:0] & mask,scalar & mask,gf13)};
+   end
+end
+
+endmodule
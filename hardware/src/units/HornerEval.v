@@ -0,0 +1,142 @@
+`timescale 1ns / 1ps
+
+// Evaluates a polynomial over GF(2^12) (x^12 + x^3 + 1), or GF(2^13) (x^13 + x^4 + x^3 + x + 1) when gf13 is set,
+// at blocks of points using Horner's rule. Used by McEliece to evaluate a polynomial at every element of the support.
+// The coefficients stay inside the unit: a run with loadCoefs set receives them as words of two coefficients, lowest degree first.
+// Other runs receive a block of points, two per word (bits 15:0 and 31:16), while streaming out the values at the points
+// of the previous block. When evaluate is set the unit then applies one Horner step per coefficient to every word of the
+// block, both halves in the same cycle, and only finishes after words * (degree + 1) cycles.
+// When enable is not set the unit finishes immediately, so that it does not lengthen the runs of other algorithms.
+module HornerEval #(
+         parameter DELAY_W = 7,
+         parameter DATA_W = 32
+              )
+    (
+    //control
+    input               clk,
+    input               rst,
+
+    input               running,
+    input               run,
+    output              done,
+
+    //input / output data
+    input [DATA_W-1:0]  in0,
+
+    (* versat_latency = 1 *) output reg [DATA_W-1:0] out0,
+
+    //configurations
+    input               enable,    // Take part in this run
+    input               loadCoefs, // Replace the coefficients with the words received
+    input               evaluate,  // Evaluate the polynomial at the block of points received
+    input [6:0]         words,     // Words received and streamed out this run. At most 64 for points and 65 for coefficients
+    input [7:0]         degree,    // Degree of the polynomial, at most 129
+    input               gf13,
+
+    input [DELAY_W-1:0] delay0 // Encodes delay
+    );
+
+localparam BLOCK = 64;
+
+reg [DELAY_W-1:0] delay;
+reg [6:0] index;
+reg [7:0] c; // Coefficient added by the Horner step being applied
+reg busy;
+reg computing;
+
+reg [12:0] coef[129:0];
+reg [31:0] point[BLOCK-1:0];
+reg [31:0] value[BLOCK-1:0];
+
+assign done = !busy;
+
+// Carry-less product followed by the reduction of the bits above the field size, from the highest one down
+function [12:0] GF_MUL(input [12:0] a,input [12:0] b,input gf13);
+integer i;
+reg [24:0] p;
+begin
+   p = 25'h0;
+   for(i = 0; i < 13; i = i + 1) begin
+      if(b[i]) begin
+         p = p ^ ({12'h0,a} << i);
+      end
+   end
+
+   for(i = 24; i >= 12; i = i - 1) begin
+      if(gf13) begin
+         if(i >= 13 && p[i]) begin
+            p = p ^ (25'h201B << (i - 13));
+         end
+      end else if(p[i]) begin
+         p = p ^ (25'h1009 << (i - 12));
+      end
+   end
+
+   GF_MUL = p[12:0];
+end
+endfunction
+
+wire [12:0] mask = gf13 ? 13'h1FFF : 13'h0FFF;
+
+// The first step starts from zero, so it only adds the coefficient of highest degree
+wire [31:0] x = point[index[5:0]];
+wire [31:0] acc = (c == degree) ? 32'h0 : value[index[5:0]];
+wire [12:0] low = GF_MUL(acc[12:0],x[12:0] & mask,gf13) ^ coef[c];
+wire [12:0] high = GF_MUL(acc[28:16],x[28:16] & mask,gf13) ^ coef[c];
+
+always @(posedge clk,posedge rst)
+begin
+   if(rst) begin
+      delay <= 0;
+      index <= 0;
+      c <= 0;
+      busy <= 0;
+      computing <= 0;
+      out0 <= 0;
+   end else if(run) begin
+      delay <= delay0; // wait delay0 cycles for valid input data
+      index <= 0;
+      busy <= enable;
+      computing <= 0;
+   end else if(busy) begin
+      if(|delay) begin
+         delay <= delay - 1;
+      end else if(!computing) begin
+         out0 <= value[index[5:0]];
+
+         if(loadCoefs) begin
+            coef[{index,1'b0}] <= in0[12:0] & mask;
+            coef[{index,1'b1}] <= in0[28:16] & mask;
+         end else begin
+            point[index[5:0]] <= in0;
+         end
+
+         if(index == words - 7'd1) begin
+            index <= 0;
+            c <= degree;
+            if(evaluate && !loadCoefs) begin
+               computing <= 1;
+            end else begin
+               busy <= 0;
+            end
+         end else begin
+            index <= index + 1;
+         end
+      end else begin
+         value[index[5:0]] <= {3'h0,high,3'h0,low};
+
+         if(index == words - 7'd1) begin
+            index <= 0;
+            if(c == 0) begin
+               busy <= 0;
+            end else begin
+               c <= c - 1;
+            end
+         end else begin
+            index <= index + 1;
+         end
+      end
+   end
+end
+
+endmodule
@@ -0,0 +1,185 @@
+`timescale 1ns / 1ps
+
+// Keccak-f[1600] permutation. The 1600 bit state is kept inside the unit between runs.
+// Every run streams the 50 words of the state through out0 (lane i is word 2*i for the low half and 2*i+1 for the high half)
+// while the first absorbWords words received in in0 are XORed into the state.
+// After the 50 words are streamed, if permute is set, the 24 rounds are applied, one per cycle.
+// Since the state is output before the permutation, squeezing a block is one run behind the permutation that produced it.
+// When enable is not set the unit finishes immediately, so that it does not lengthen the runs of other algorithms.
+module KeccakF1600 #(
+         parameter DELAY_W = 7,
+         parameter DATA_W = 32
+              )
+    (
+    //control
+    input               clk,
+    input               rst,
+
+    input               running,
+    input               run,
+    output              done,
+
+    //input / output data
+    input [DATA_W-1:0]  in0,
+
+    (* versat_latency = 1 *) output reg [DATA_W-1:0] out0,
+
+    //configurations
+    input               enable,      // Stream the state this run
+    input               clear,       // Zeroes the state at the start of the run
+    input [5:0]         absorbWords, // How many words of in0 are XORed into the state
+    input               permute,     // Apply the permutation after streaming the state
+
+    input [DELAY_W-1:0] delay0 // Encodes delay
+    );
+
+reg [DELAY_W-1:0] delay;
+reg [5:0] index;
+reg [4:0] round;
+reg streaming;
+reg permuting;
+
+reg [63:0] A[24:0];
+
+assign done = !(streaming | permuting);
+
+function [63:0] ROTL_64(input [63:0] x,input [5:0] c);
+begin
+   ROTL_64 = ((x << c) | (x >> (64 - c)));
+end
+endfunction
+
+// Rotation offsets of the rho step, indexed by x + 5 * y
+function [5:0] RHO(input integer i);
+begin
+   case(i)
+   0:  RHO = 0;  1:  RHO = 1;  2:  RHO = 62; 3:  RHO = 28; 4:  RHO = 27;
+   5:  RHO = 36; 6:  RHO = 44; 7:  RHO = 6;  8:  RHO = 55; 9:  RHO = 20;
+   10: RHO = 3;  11: RHO = 10; 12: RHO = 43; 13: RHO = 25; 14: RHO = 39;
+   15: RHO = 41; 16: RHO = 45; 17: RHO = 15; 18: RHO = 21; 19: RHO = 8;
+   20: RHO = 18; 21: RHO = 2;  22: RHO = 61; 23: RHO = 56; 24: RHO = 14;
+   default: RHO = 0;
+   endcase
+end
+endfunction
+
+function [63:0] RC(input [4:0] r);
+begin
+   case(r)
+   5'd0:  RC = 64'h0000000000000001;
+   5'd1:  RC = 64'h0000000000008082;
+   5'd2:  RC = 64'h800000000000808A;
+   5'd3:  RC = 64'h8000000080008000;
+   5'd4:  RC = 64'h000000000000808B;
+   5'd5:  RC = 64'h0000000080000001;
+   5'd6:  RC = 64'h8000000080008081;
+   5'd7:  RC = 64'h8000000000008009;
+   5'd8:  RC = 64'h000000000000008A;
+   5'd9:  RC = 64'h0000000000000088;
+   5'd10: RC = 64'h0000000080008009;
+   5'd11: RC = 64'h000000008000000A;
+   5'd12: RC = 64'h000000008000808B;
+   5'd13: RC = 64'h800000000000008B;
+   5'd14: RC = 64'h8000000000008089;
+   5'd15: RC = 64'h8000000000008003;
+   5'd16: RC = 64'h8000000000008002;
+   5'd17: RC = 64'h8000000000000080;
+   5'd18: RC = 64'h000000000000800A;
+   5'd19: RC = 64'h800000008000000A;
+   5'd20: RC = 64'h8000000080008081;
+   5'd21: RC = 64'h8000000000008080;
+   5'd22: RC = 64'h0000000080000001;
+   5'd23: RC = 64'h8000000080008008;
+   default: RC = 64'h0;
+   endcase
+end
+endfunction
+
+// One round of the permutation (theta, rho, pi, chi and iota)
+reg [63:0] C[4:0];
+reg [63:0] D[4:0];
+reg [63:0] B[24:0];
+reg [63:0] next[24:0];
+
+integer x,y;
+always @* begin
+   for(x = 0; x < 5; x = x + 1) begin
+      C[x] = A[x] ^ A[x + 5] ^ A[x + 10] ^ A[x + 15] ^ A[x + 20];
+   end
+
+   for(x = 0; x < 5; x = x + 1) begin
+      D[x] = C[(x + 4) % 5] ^ ROTL_64(C[(x + 1) % 5],1);
+   end
+
+   for(x = 0; x < 5; x = x + 1) begin
+      for(y = 0; y < 5; y = y + 1) begin
+         B[y + 5 * ((2 * x + 3 * y) % 5)] = ROTL_64(A[x + 5 * y] ^ D[x],RHO(x + 5 * y));
+      end
+   end
+
+   for(x = 0; x < 5; x = x + 1) begin
+      for(y = 0; y < 5; y = y + 1) begin
+         next[x + 5 * y] = B[x + 5 * y] ^ (~B[(x + 1) % 5 + 5 * y] & B[(x + 2) % 5 + 5 * y]);
+      end
+   end
+
+   next[0] = next[0] ^ RC(round);
+end
+
+wire [63:0] lane = A[index[5:1]];
+
+integer i;
+always @(posedge clk,posedge rst)
+begin
+   if(rst) begin
+      delay <= 0;
+      index <= 0;
+      round <= 0;
+      streaming <= 0;
+      permuting <= 0;
+      out0 <= 0;
+      for(i = 0; i < 25; i = i + 1)
+         A[i] <= 0;
+   end else if(run) begin
+      delay <= delay0; // wait delay0 cycles for valid input data
+      index <= 0;
+      round <= 0;
+      streaming <= enable;
+      permuting <= 0;
+      if(enable && clear) begin
+         for(i = 0; i < 25; i = i + 1)
+            A[i] <= 0;
+      end
+   end else if(streaming) begin
+      if(|delay) begin
+         delay <= delay - 1;
+      end else begin
+         out0 <= index[0] ? lane[63:32] : lane[31:0];
+
+         if(index < absorbWords) begin
+            if(index[0])
+               A[index[5:1]][63:32] <= lane[63:32] ^ in0;
+            else
+               A[index[5:1]][31:0] <= lane[31:0] ^ in0;
+         end
+
+         index <= index + 1;
+
+         if(index == 6'd49) begin
+            streaming <= 0;
+            permuting <= permute;
+         end
+      end
+   end else if(permuting) begin
+      for(i = 0; i < 25; i = i + 1)
+         A[i] <= next[i];
+
+      round <= round + 1;
+
+      if(round == 5'd23) begin
+         permuting <= 0;
+      end
+   end
+end
+
+endmodule
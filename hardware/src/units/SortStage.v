@@ -0,0 +1,86 @@
+`timescale 1ns / 1ps
+
+// One stage of a bitonic sorting network, applied to a stream of elements.
+// Element u is compare-exchanged with element u ^ 2^lgDist: the lower of the two positions receives the minimum when
+// the sequence is ascending at that position ((offset + u) & dirMask == 0) and the maximum otherwise.
+// Elements are either signed 32 bit words or unsigned 64 bit values sent as two words, low half first (wide).
+// Every input word is kept in a circular buffer and the output is a fixed number of cycles behind the input, enough
+// for the partner of an element to have arrived for any distance up to 32 elements. The time taken and the memory
+// accessed do not depend on the values being sorted.
+module SortStage #(
+         parameter DELAY_W = 7,
+         parameter DATA_W = 32
+              )
+    (
+    //control
+    input               clk,
+    input               rst,
+
+    input               running,
+    input               run,
+    output              done,
+
+    //input / output data
+    input [DATA_W-1:0]  in0,
+
+    (* versat_latency = 131 *) output reg [DATA_W-1:0] out0,
+
+    //configurations
+    input               wide,     // 64 bit unsigned elements instead of signed 32 bit
+    input [2:0]         lgDist,   // Compare-exchange distance is 2^lgDist elements, at most 32
+    input [15:0]        dirMask,  // Block size of the bitonic sort step, selects the direction of each position
+    input [15:0]        offset,   // Index of the first element of the stream in the whole sequence
+
+    input [DELAY_W-1:0] delay0 // Encodes delay
+    );
+
+// Words between an input and its output. An element and its partner take at most 2 * 2 * 32 + 2 words
+localparam DISTANCE = 130;
+
+assign done = 1'b1;
+
+reg [DELAY_W-1:0] delay;
+reg [15:0] counter;
+
+reg [31:0] buffer[255:0];
+
+wire [15:0] position = counter - DISTANCE; // Word being output
+wire [15:0] dist = 16'd1 << lgDist;
+
+wire [15:0] u = wide ? {1'b0,position[15:1]} : position;
+wire [15:0] v = u ^ dist;
+
+wire [63:0] a = wide ? {buffer[{u[6:0],1'b1}],buffer[{u[6:0],1'b0}]} : {{32{buffer[u[7:0]][31]}},buffer[u[7:0]]};
+wire [63:0] b = wide ? {buffer[{v[6:0],1'b1}],buffer[{v[6:0],1'b0}]} : {{32{buffer[v[7:0]][31]}},buffer[v[7:0]]};
+
+// Sign extended 32 bit values compare correctly as signed 64 bit values
+wire less = wide ? (a < b) : ($signed(a) < $signed(b));
+
+wire lower = ((u & dist) == 0);
+wire ascending = (((offset + u) & dirMask) == 0);
+wire [63:0] min = less ? a : b;
+wire [63:0] max = less ? b : a;
+wire [63:0] result = (lower == ascending) ? min : max;
+
+always @(posedge clk,posedge rst)
+begin
+   if(rst) begin
+      delay <= 0;
+      counter <= 0;
+      out0 <= 0;
+   end else if(run) begin
+      delay <= delay0; // wait delay0 cycles for valid input data
+      counter <= 0;
+   end else if(running) begin
+      if(|delay) begin
+         delay <= delay - 1;
+      end else begin
+         buffer[counter[7:0]] <= in0;
+         counter <= counter + 1;
+
+         out0 <= (wide & position[0]) ? result[63:32] : result[31:0];
+      end
+   end
+end
+
+endmodule
@@ -1,5 +1,5 @@
-#ifndef PQCLEAN_MCELIECE348864_CLEAN_AES256CTR_H
-#define PQCLEAN_MCELIECE348864_CLEAN_AES256CTR_H
+#ifndef PQCLEAN_MCELIECE_CLEAN_AES256CTR_H
+#define PQCLEAN_MCELIECE_CLEAN_AES256CTR_H
 
 #include <stddef.h>
 #include <stdint.h>
@@ -1,27 +1,38 @@
-#ifndef PQCLEAN_MCELIECE348864_CLEAN_API_H
-#define PQCLEAN_MCELIECE348864_CLEAN_API_H
+#ifndef PQCLEAN_MCELIECE_CLEAN_API_H
+#define PQCLEAN_MCELIECE_CLEAN_API_H
 
 #include <stdint.h>
 
-#define PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_ALGNAME "Classic McEliece 348864"
-#define PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_PUBLICKEYBYTES 261120
-#define PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_SECRETKEYBYTES 6492
-#define PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_CIPHERTEXTBYTES 96
-#define PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_BYTES 32
+#include "params.h"
 
-int PQCLEAN_MCELIECE348864_CLEAN_crypto_kem_enc(
+/* The names are the same for every parameter set, the algorithm name and the sizes follow MCELIECE_PARAMETER_SET */
+#if MCELIECE_PARAMETER_SET == MCELIECE348864
+#define PQCLEAN_MCELIECE_CLEAN_CRYPTO_ALGNAME "Classic McEliece 348864"
+#elif MCELIECE_PARAMETER_SET == MCELIECE460896
+#define PQCLEAN_MCELIECE_CLEAN_CRYPTO_ALGNAME "Classic McEliece 460896"
+#elif MCELIECE_PARAMETER_SET == MCELIECE6688128
+#define PQCLEAN_MCELIECE_CLEAN_CRYPTO_ALGNAME "Classic McEliece 6688128"
+#elif MCELIECE_PARAMETER_SET == MCELIECE8192128
+#define PQCLEAN_MCELIECE_CLEAN_CRYPTO_ALGNAME "Classic McEliece 8192128"
+#endif
+#define PQCLEAN_MCELIECE_CLEAN_CRYPTO_PUBLICKEYBYTES (PK_NROWS * PK_ROW_BYTES)
+#define PQCLEAN_MCELIECE_CLEAN_CRYPTO_SECRETKEYBYTES (40 + IRR_BYTES + COND_BYTES + SYS_N / 8)
+#define PQCLEAN_MCELIECE_CLEAN_CRYPTO_CIPHERTEXTBYTES SYND_BYTES
+#define PQCLEAN_MCELIECE_CLEAN_CRYPTO_BYTES 32
+
+int PQCLEAN_MCELIECE_CLEAN_crypto_kem_enc(
     uint8_t *c,
     uint8_t *key,
     const uint8_t *pk
 );
 
-int PQCLEAN_MCELIECE348864_CLEAN_crypto_kem_dec(
+int PQCLEAN_MCELIECE_CLEAN_crypto_kem_dec(
     uint8_t *key,
     const uint8_t *c,
     const uint8_t *sk
 );
 
-int PQCLEAN_MCELIECE348864_CLEAN_crypto_kem_keypair
+int PQCLEAN_MCELIECE_CLEAN_crypto_kem_keypair
 (
     uint8_t *pk,
     uint8_t *sk
@@ -16,18 +16,35 @@ Arena InitArena(int size){
   return arena;
 }
 
+// Memory after the end of the arena belongs to something else, so there is no way to continue
+static void ArenaOverflow(Arena* arena,int size){
+  printf("Arena overflow\n");
+  printf("Size: %d,Used: %d, Allocated: %d\n",size,arena->used,arena->allocated);
+  exit(111);
+}
+
 void* PushBytes(Arena* arena,int size){
-  char* ptr = &arena->ptr[arena->used];
+  return PushAlignedBytes(arena,size,4);
+}
+
+// alignment must be a power of two. It applies to the address, since the start of the arena might not be aligned to it
+void* PushAlignedBytes(Arena* arena,int size,int alignment){
+  uintptr_t base = (uintptr_t) arena->ptr;
+  uintptr_t start = (base + arena->used + alignment - 1) & ~((uintptr_t) alignment - 1);
+  int offset = (int) (start - base);
 
-  size = (size + 3) & (~3); // Align to 4 byte boundary
-  arena->used += size;
+  size = (size + 3) & (~3); // Keeps the following pushes aligned to 4 byte boundary
 
-  if(arena->used > arena->allocated){
-    printf("Arena overflow\n");
-    printf("Size: %d,Used: %d, Allocated: %d\n",size,arena->used,arena->allocated);
+  if(offset + size > arena->allocated){
+    ArenaOverflow(arena,size);
   }
 
-  return ptr;
+  arena->used = offset + size;
+  if(arena->used > arena->highWater){
+    arena->highWater = arena->used;
+  }
+
+  return &arena->ptr[offset];
 }
 
 void* PushAndZeroBytes(Arena* arena,int size){
@@ -39,6 +56,7 @@ void* PushAndZeroBytes(Arena* arena,int size){
   return ptr;
 }
 
+// The memory is released by popping the parent arena to a mark taken before this call
 int MarkArena(Arena* arena){
   return arena->used;
 }
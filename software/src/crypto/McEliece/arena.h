@@ -6,17 +6,20 @@ typedef struct{
   char* ptr;
   int used;
   int allocated;
+  int highWater; // Largest value reached by used, to size the arena from measurements
 } Arena;
 
 extern Arena* globalArena;
 
 Arena InitArena(int size);
 void* PushBytes(Arena* arena,int size);
+void* PushAlignedBytes(Arena* arena,int size,int alignment);
 void* PushAndZeroBytes(Arena* arena,int size);
 int MarkArena(Arena* arena);
 void PopArena(Arena* arena,int mark);
 
-#define PushArray(ARENA,N_ELEM,TYPE)        (TYPE*) PushBytes(ARENA,(N_ELEM) * sizeof(TYPE))
-#define PushAndZeroArray(ARENA,N_ELEM,TYPE) (TYPE*) PushAndZeroBytes(ARENA,(N_ELEM) * sizeof(TYPE))
+#define PushArray(ARENA,N_ELEM,TYPE)              (TYPE*) PushBytes(ARENA,(N_ELEM) * sizeof(TYPE))
+#define PushAlignedArray(ARENA,N_ELEM,TYPE,ALIGN) (TYPE*) PushAlignedBytes(ARENA,(N_ELEM) * sizeof(TYPE),ALIGN)
+#define PushAndZeroArray(ARENA,N_ELEM,TYPE)       (TYPE*) PushAndZeroBytes(ARENA,(N_ELEM) * sizeof(TYPE))
 
 #endif // H_MEMORY_POOL_H
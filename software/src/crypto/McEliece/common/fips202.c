@@ -12,6 +12,12 @@
 
 #include "fips202.h"
 
+#ifdef VERSAT_KECCAK
+/* The permutation, and the absorb and squeeze loops over full blocks,
+   run on the Keccak unit of the Versat accelerator */
+#include "versat_crypto.h"
+#endif
+
 #define NROUNDS 24
 #define ROL(a, offset) (((a) << (offset)) ^ ((a) >> (64 - (offset))))
 
@@ -33,6 +39,7 @@ static uint64_t load64(const uint8_t *x) {
     return r;
 }
 
+#ifndef VERSAT_KECCAK
 /*************************************************
  * Name:        store64
  *
@@ -46,8 +53,12 @@ static void store64(uint8_t *x, uint64_t u) {
         x[i] = (uint8_t) (u >> 8 * i);
     }
 }
+#endif
 
 /* Keccak round constants */
+#ifdef VERSAT_KECCAK
+#define KeccakF1600_StatePermute VersatKeccakF1600
+#else
 static const uint64_t KeccakF_RoundConstants[NROUNDS] = {
     0x0000000000000001ULL, 0x0000000000008082ULL,
     0x800000000000808aULL, 0x8000000080008000ULL,
@@ -332,6 +343,7 @@ static void KeccakF1600_StatePermute(uint64_t *state) {
     state[23] = Aso;
     state[24] = Asu;
 }
+#endif
 
 /*************************************************
  * Name:        keccak_absorb
@@ -356,6 +368,11 @@ static void keccak_absorb(uint64_t *s, uint32_t r, const uint8_t *m,
         s[i] = 0;
     }
 
+#ifdef VERSAT_KECCAK
+    VersatKeccakAbsorbBlocks(s, r, m, mlen / r);
+    m += (mlen / r) * r;
+    mlen %= r;
+#else
     while (mlen >= r) {
         for (i = 0; i < r / 8; ++i) {
             s[i] ^= load64(m + 8 * i);
@@ -365,6 +382,7 @@ static void keccak_absorb(uint64_t *s, uint32_t r, const uint8_t *m,
         mlen -= r;
         m += r;
     }
+#endif
 
     for (i = 0; i < r; ++i) {
         t[i] = 0;
@@ -394,6 +412,9 @@ static void keccak_absorb(uint64_t *s, uint32_t r, const uint8_t *m,
  **************************************************/
 static void keccak_squeezeblocks(uint8_t *h, size_t nblocks,
                                  uint64_t *s, uint32_t r) {
+#ifdef VERSAT_KECCAK
+    VersatKeccakSqueezeBlocks(h, nblocks, s, r);
+#else
     while (nblocks > 0) {
         KeccakF1600_StatePermute(s);
         for (size_t i = 0; i < (r >> 3); i++) {
@@ -402,6 +423,7 @@ static void keccak_squeezeblocks(uint8_t *h, size_t nblocks,
         h += r;
         nblocks--;
     }
+#endif
 }
 
 /*************************************************
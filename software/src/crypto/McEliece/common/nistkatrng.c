@@ -12,6 +12,10 @@
 #include "aes.h"
 #include "randombytes.h"
 
+#ifdef VERSAT_DRBG
+#include "versat_crypto.h"
+#endif
+
 typedef struct {
     uint8_t Key[32];
     uint8_t V[16];
@@ -23,13 +27,30 @@ static void AES256_CTR_DRBG_Update(const uint8_t *provided_data, uint8_t *Key, u
 
 // Use whatever AES implementation you have. This uses AES from openSSL library
 //    key - 256-bit AES key
-//    ctr - a 128-bit plaintext value
-//    buffer - a 128-bit ciphertext value
-static void AES256_ECB(uint8_t *key, uint8_t *ctr, uint8_t *buffer) {
+//    V - 128-bit counter, incremented before each block
+//    buffer - nblocks 128-bit ciphertext values
+// The key is expanded once for all the blocks
+static void AES256_CTR(uint8_t *key, uint8_t *V, uint8_t *buffer, size_t nblocks) {
+#ifdef VERSAT_DRBG
+    /* The accelerator keeps the expanded key between calls while it does not change */
+    VersatAES256CTRBlocks(key, V, buffer, nblocks);
+#else
     aes256ctx ctx;
     aes256_ecb_keyexp(&ctx, key);
-    aes256_ecb(buffer, ctr, 1, &ctx);
+    for (size_t i = 0; i < nblocks; i++) {
+        //increment V
+        for (int j = 15; j >= 0; j--) {
+            if (V[j] == 0xff) {
+                V[j] = 0x00;
+            } else {
+                V[j]++;
+                break;
+            }
+        }
+        aes256_ecb(buffer + 16 * i, V, 1, &ctx);
+    }
     aes256_ctx_release(&ctx);
+#endif
 }
 
 void nist_kat_init(uint8_t *entropy_input, const uint8_t *personalization_string, int security_strength);
@@ -52,27 +73,12 @@ void nist_kat_init(uint8_t *entropy_input, const uint8_t *personalization_string
 #if 1
 int randombytes(uint8_t *buf, size_t n) {
     uint8_t block[16];
-    int i = 0;
 
-    while (n > 0) {
-        //increment V
-        for (int j = 15; j >= 0; j--) {
-            if (DRBG_ctx.V[j] == 0xff) {
-                DRBG_ctx.V[j] = 0x00;
-            } else {
-                DRBG_ctx.V[j]++;
-                break;
-            }
-        }
-        AES256_ECB(DRBG_ctx.Key, DRBG_ctx.V, block);
-        if (n > 15) {
-            memcpy(buf + i, block, 16);
-            i += 16;
-            n -= 16;
-        } else {
-            memcpy(buf + i, block, n);
-            n = 0;
-        }
+    /* Full blocks are generated in place, all with the same key */
+    AES256_CTR(DRBG_ctx.Key, DRBG_ctx.V, buf, n / 16);
+    if (n % 16) {
+        AES256_CTR(DRBG_ctx.Key, DRBG_ctx.V, block, 1);
+        memcpy(buf + n - n % 16, block, n % 16);
     }
     AES256_CTR_DRBG_Update(NULL, DRBG_ctx.Key, DRBG_ctx.V);
     DRBG_ctx.reseed_counter++;
@@ -83,19 +89,7 @@ int randombytes(uint8_t *buf, size_t n) {
 static void AES256_CTR_DRBG_Update(const uint8_t *provided_data, uint8_t *Key, uint8_t *V) {
     uint8_t temp[48];
 
-    for (int i = 0; i < 3; i++) {
-        //increment V
-        for (int j = 15; j >= 0; j--) {
-            if (V[j] == 0xff) {
-                V[j] = 0x00;
-            } else {
-                V[j]++;
-                break;
-            }
-        }
-
-        AES256_ECB(Key, V, temp + 16 * i);
-    }
+    AES256_CTR(Key, V, temp, 3);
     if (provided_data != NULL) {
         for (int i = 0; i < 48; i++) {
             temp[i] ^= provided_data[i];
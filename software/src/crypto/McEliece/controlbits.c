@@ -5,7 +5,13 @@
 //#include "compat.h"
 #include "controlbits.h"
 #include "crypto_declassify.h"
+#ifdef VERSAT_SORT
+/* The sorting networks run on the Sort unit of the Versat accelerator */
+#include "versat_crypto.h"
+#define int32_sort VersatSortI32
+#else
 #include "int32_sort.h"
+#endif
 #include <string.h>
 typedef int16_t int16;
 typedef int32_t int32;
@@ -14,27 +20,21 @@ typedef int32_t int32;
 #include "crypto_int16.h"
 
 #include "arena.h"
-#include "printf.h"
 
 /* parameters: 1 <= w <= 14; n = 2^w */
 /* input: permutation pi of {0,1,...,n-1} */
-/* output: (2m-1)n/2 control bits at positions pos,pos+step,... */
+/* output: first and last layer of the (2m-1)n/2 control bits at positions pos,pos+step,... */
+/* output: q0, q1, the permutations of size n/2 that the middle layers */
+/*         at positions pos+step*n/2 and pos+step*n/2+step must implement */
 /* output position pos is by definition 1&(out[pos/8]>>(pos&7)) */
 /* caller must 0-initialize positions first */
 /* temp must have space for int32[2*n] */
-static void cbrecursion(unsigned char *out, long long pos, long long step, const int16 *pi, long long w, long long n, int32 *temp) {
+static void cbstep(unsigned char *out, long long pos, long long step, const int16 *pi, long long w, long long n, int32 *temp, int16 *q0, int16 *q1) {
 #define A temp
 #define B (temp+n)
-#define q ((int16 *) (temp+n+n/4))
-    /* q can start anywhere between temp+n and temp+n/2 */
 
     long long x, y, i, j, k;
 
-#if 0
-    static int times = 0;
-    printf("%d\n",times++);
-#endif
-  
     if (w == 1) {
         out[pos >> 3] ^= pi[0] << (pos & 7);
         return;
@@ -171,15 +171,40 @@ static void cbrecursion(unsigned char *out, long long pos, long long step, const
 
     int32_sort(A, n); /* A = (id<<16)+F(pi(L)) = (id<<16)+M */
 
-    pos -= (2 * w - 2) * step * (n / 2);
-
     for (j = 0; j < n / 2; ++j) {
-        q[j] = (A[2 * j] & 0xffff) >> 1;
-        q[j + n / 2] = (A[2 * j + 1] & 0xffff) >> 1;
+        q0[j] = (A[2 * j] & 0xffff) >> 1;
+        q1[j] = (A[2 * j + 1] & 0xffff) >> 1;
     }
+#undef A
+#undef B
+}
 
-    cbrecursion(out, pos, step * 2, q, w - 1, n / 2, temp);
-    cbrecursion(out, pos + step, step * 2, q + n / 2, w - 1, n / 2, temp);
+/* Same result as the recursive version, solving the recursion one level at a time */
+/* Subproblem t of level l has size n/2^l and its control bits start */
+/* at position l*n/2+t with step 2^l. Its two halves become subproblems */
+/* t and t+2^l of level l+1, so each level fits in an array of n elements */
+/* parameters: 1 <= w <= 14; n = 2^w */
+/* input: permutation pi of {0,1,...,n-1} */
+/* output: (2m-1)n/2 control bits at positions 0,1,... */
+/* caller must 0-initialize positions first */
+/* temp must have space for int32[2*n], level0 and level1 for int16[n] each */
+static void cbiterative(unsigned char *out, const int16 *pi, long long w, long long n, int32 *temp, int16 *level0, int16 *level1) {
+    long long l, t, m, count;
+    const int16 *cur = pi;
+    int16 *next;
+
+    for (l = 0; l < w; ++l) {
+        m = n >> l;
+        count = 1LL << l;
+        next = (l & 1) ? level1 : level0;
+
+        for (t = 0; t < count; ++t) {
+            cbstep(out, l * (n / 2) + t, count, cur + t * m, w - l, m, temp,
+                   next + t * (m / 2), next + (t + count) * (m / 2));
+        }
+
+        cur = next;
+    }
 }
 
 /* input: p, an array of int16 */
@@ -213,24 +238,20 @@ static void layer(int16_t *p, const unsigned char *cb, int s, int n) {
 /* output: (2m-1)n/2 control bits at positions 0,1,... */
 /* output position pos is by definition 1&(out[pos/8]>>(pos&7)) */
 void controlbitsfrompermutation(unsigned char *out, const int16 *pi, long long w, long long n) {
-    //PQCLEAN_VLA(int32, temp, (size_t)(2 * n));
-    //PQCLEAN_VLA(int16, pi_test, (size_t)n);
-
     int mark = MarkArena(globalArena);
 
-    int32* temp = PushAndZeroBytes(globalArena,2 * n * sizeof(int32));
-    int16* pi_test = PushAndZeroBytes(globalArena,n * sizeof(int16));
+    int32* temp = PushArray(globalArena,2 * n,int32);
+    int16* level0 = PushArray(globalArena,n,int16);
+    int16* level1 = PushArray(globalArena,n,int16);
+    int16* pi_test = PushArray(globalArena,n,int16);
 
     int16 diff;
     int i;
     unsigned char *ptr;
 
-    memset(temp, 0, (size_t)n * 2);
-    memset(pi_test, 0, (size_t)n);
-
     while (1) {
         memset(out, 0, (size_t)((((2 * w - 1)*n / 2) + 7) / 8));
-        cbrecursion(out, 0, 1, pi, w, n, temp);
+        cbiterative(out, pi, w, n, temp, level0, level1);
 
         // check for correctness
 
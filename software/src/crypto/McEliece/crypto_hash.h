@@ -1,5 +1,5 @@
-#ifndef PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_HASH_H
-#define PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_HASH_H
+#ifndef PQCLEAN_MCELIECE_CLEAN_CRYPTO_HASH_H
+#define PQCLEAN_MCELIECE_CLEAN_CRYPTO_HASH_H
 
 #include "fips202.h"
 
@@ -1,5 +1,5 @@
-#ifndef PQCLEAN_MCELIECE348864_CLEAN_crypto_int16_h
-#define PQCLEAN_MCELIECE348864_CLEAN_crypto_int16_h
+#ifndef PQCLEAN_MCELIECE_CLEAN_crypto_int16_h
+#define PQCLEAN_MCELIECE_CLEAN_crypto_int16_h
 
 #include <inttypes.h>
 
@@ -1,5 +1,5 @@
-#ifndef PQCLEAN_MCELIECE348864_CLEAN_crypto_int32_h
-#define PQCLEAN_MCELIECE348864_CLEAN_crypto_int32_h
+#ifndef PQCLEAN_MCELIECE_CLEAN_crypto_int32_h
+#define PQCLEAN_MCELIECE_CLEAN_crypto_int32_h
 
 #include <inttypes.h>
 typedef int32_t crypto_int32;
@@ -1,5 +1,5 @@
-#ifndef PQCLEAN_MCELIECE348864_CLEAN_crypto_uint16_h
-#define PQCLEAN_MCELIECE348864_CLEAN_crypto_uint16_h
+#ifndef PQCLEAN_MCELIECE_CLEAN_crypto_uint16_h
+#define PQCLEAN_MCELIECE_CLEAN_crypto_uint16_h
 
 #include <inttypes.h>
 typedef uint16_t crypto_uint16;
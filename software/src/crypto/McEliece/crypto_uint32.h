@@ -1,5 +1,5 @@
-#ifndef PQCLEAN_MCELIECE348864_CLEAN_crypto_uint32_h
-#define PQCLEAN_MCELIECE348864_CLEAN_crypto_uint32_h
+#ifndef PQCLEAN_MCELIECE_CLEAN_crypto_uint32_h
+#define PQCLEAN_MCELIECE_CLEAN_crypto_uint32_h
 
 #include <inttypes.h>
 typedef uint32_t crypto_uint32;
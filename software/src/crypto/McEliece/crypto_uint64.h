@@ -1,5 +1,5 @@
-#ifndef PQCLEAN_MCELIECE348864_CLEAN_crypto_uint64_h
-#define PQCLEAN_MCELIECE348864_CLEAN_crypto_uint64_h
+#ifndef PQCLEAN_MCELIECE_CLEAN_crypto_uint64_h
+#define PQCLEAN_MCELIECE_CLEAN_crypto_uint64_h
 
 #include <inttypes.h>
 typedef uint64_t crypto_uint64;
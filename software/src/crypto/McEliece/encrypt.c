@@ -14,6 +14,7 @@
 #include "crypto_uint16.h"
 #include "crypto_uint32.h"
 #include "gf.h"
+#include "int32_sort.h"
 
 /* include last because of conflict with unistd.h encrypt function */
 #include "encrypt.h"
@@ -30,41 +31,50 @@ static inline crypto_uint32 uint32_is_equal_declassify(uint32_t t, uint32_t u) {
     return mask;
 }
 
-static inline unsigned char same_mask(uint16_t x, uint16_t y) {
-    uint32_t mask;
+static inline uint64_t same_mask(uint16_t x, uint16_t y) {
+    uint64_t mask;
 
     mask = x ^ y;
     mask -= 1;
-    mask >>= 31;
+    mask >>= 63;
     mask = -mask;
 
-    return mask & 0xFF;
+    return mask;
 }
 
+/* When every GFBITS bit value is a position, t values are drawn instead of 2t */
+#if SYS_N == (1 << GFBITS)
+#define GEN_E_NUMS SYS_T
+#else
+#define GEN_E_NUMS (SYS_T * 2)
+#endif
+
 /* output: e, an error vector of weight t */
 static void gen_e(unsigned char *e) {
     int i, j, eq, count;
 
     union {
-        uint16_t nums[ SYS_T * 2 ];
-        unsigned char bytes[ SYS_T * 2 * sizeof(uint16_t) ];
+        uint16_t nums[ GEN_E_NUMS ];
+        unsigned char bytes[ GEN_E_NUMS * sizeof(uint16_t) ];
     } buf;
 
     uint16_t ind[ SYS_T ];
-    unsigned char mask;
-    unsigned char val[ SYS_T ];
+    int32_t sorted[ SYS_T ];
+    uint64_t e_int[ (SYS_N + 63) / 64 ];
+    uint64_t val[ SYS_T ];
+    unsigned char bytes[ 8 ];
 
     while (1) {
         randombytes(buf.bytes, sizeof(buf));
 
-        for (i = 0; i < SYS_T * 2; i++) {
+        for (i = 0; i < GEN_E_NUMS; i++) {
             buf.nums[i] = load_gf(buf.bytes + i * 2);
         }
 
         // moving and counting indices in the correct range
 
         count = 0;
-        for (i = 0; i < SYS_T * 2 && count < SYS_T; i++) {
+        for (i = 0; i < GEN_E_NUMS && count < SYS_T; i++) {
             if (uint16_is_smaller_declassify(buf.nums[i], SYS_N)) {
                 ind[ count++ ] = buf.nums[i];
             }
@@ -74,15 +84,19 @@ static void gen_e(unsigned char *e) {
             continue;
         }
 
-        // check for repetition
+        // check for repetition: after sorting, equal indices are adjacent
+
+        for (i = 0; i < SYS_T; i++) {
+            sorted[i] = ind[i];
+        }
+
+        int32_sort(sorted, SYS_T);
 
         eq = 0;
 
         for (i = 1; i < SYS_T; i++) {
-            for (j = 0; j < i; j++) {
-                if (uint32_is_equal_declassify(ind[i], ind[j])) {
-                    eq = 1;
-                }
+            if (uint32_is_equal_declassify(sorted[i - 1], sorted[i])) {
+                eq = 1;
             }
         }
 
@@ -91,19 +105,28 @@ static void gen_e(unsigned char *e) {
         }
     }
 
+    // set the bits 64 at a time
+
     for (j = 0; j < SYS_T; j++) {
-        val[j] = 1 << (ind[j] & 7);
+        val[j] = (uint64_t)1 << (ind[j] & 63);
     }
 
-    for (i = 0; i < SYS_N / 8; i++) {
-        e[i] = 0;
+    for (i = 0; i < (SYS_N + 63) / 64; i++) {
+        e_int[i] = 0;
 
         for (j = 0; j < SYS_T; j++) {
-            mask = same_mask((uint16_t)i, ind[j] >> 3);
-
-            e[i] |= val[j] & mask;
+            e_int[i] |= val[j] & same_mask((uint16_t)i, ind[j] >> 6);
         }
     }
+
+    for (i = 0; i < SYS_N / 64; i++) {
+        store8(e + i * 8, e_int[i]);
+    }
+
+    if (SYS_N % 64) {
+        store8(bytes, e_int[SYS_N / 64]);
+        memcpy(e + (SYS_N / 64) * 8, bytes, (SYS_N % 64) / 8);
+    }
 }
 
 /* input: public key pk, error vector e */
@@ -21,13 +21,38 @@ gf gf_add(gf in0, gf in1) {
     return in0 ^ in1;
 }
 
+/* input: tmp, a product of degree at most 2*GFBITS-2 */
+/* return: tmp reduced modulo the field polynomial */
+static inline gf gf_reduce(uint32_t tmp) {
+    uint32_t t;
+
+#if GFBITS == 12
+    /* x^12 + x^3 + 1 */
+    t = tmp & 0x7FC000;
+    tmp ^= t >> 9;
+    tmp ^= t >> 12;
+
+    t = tmp & 0x3000;
+    tmp ^= t >> 9;
+    tmp ^= t >> 12;
+#elif GFBITS == 13
+    /* x^13 + x^4 + x^3 + x + 1 */
+    t = tmp & 0x1FF0000;
+    tmp ^= (t >> 9) ^ (t >> 10) ^ (t >> 12) ^ (t >> 13);
+
+    t = tmp & 0x000E000;
+    tmp ^= (t >> 9) ^ (t >> 10) ^ (t >> 12) ^ (t >> 13);
+#endif
+
+    return tmp & GFMASK;
+}
+
 gf gf_mul(gf in0, gf in1) {
     int i;
 
     uint32_t tmp;
     uint32_t t0;
     uint32_t t1;
-    uint32_t t;
 
     t0 = in0;
     t1 = in1;
@@ -38,15 +63,7 @@ gf gf_mul(gf in0, gf in1) {
         tmp ^= (t0 * (t1 & (1 << i)));
     }
 
-    t = tmp & 0x7FC000;
-    tmp ^= t >> 9;
-    tmp ^= t >> 12;
-
-    t = tmp & 0x3000;
-    tmp ^= t >> 9;
-    tmp ^= t >> 12;
-
-    return tmp & ((1 << GFBITS) - 1);
+    return gf_reduce(tmp);
 }
 
 /* input: field element in */
@@ -55,22 +72,13 @@ static inline gf gf_sq(gf in) {
     const uint32_t B[] = {0x55555555, 0x33333333, 0x0F0F0F0F, 0x00FF00FF};
 
     uint32_t x = in;
-    uint32_t t;
 
     x = (x | (x << 8)) & B[3];
     x = (x | (x << 4)) & B[2];
     x = (x | (x << 2)) & B[1];
     x = (x | (x << 1)) & B[0];
 
-    t = x & 0x7FC000;
-    x ^= t >> 9;
-    x ^= t >> 12;
-
-    t = x & 0x3000;
-    x ^= t >> 9;
-    x ^= t >> 12;
-
-    return x & ((1 << GFBITS) - 1);
+    return gf_reduce(x);
 }
 
 gf gf_inv(gf in) {
@@ -86,6 +94,7 @@ gf gf_inv(gf in) {
     out = gf_sq(out);
     tmp_1111 = gf_mul(out, tmp_11); // 1111
 
+#if GFBITS == 12
     out = gf_sq(tmp_1111);
     out = gf_sq(out);
     out = gf_sq(out);
@@ -100,6 +109,22 @@ gf gf_inv(gf in) {
     out = gf_mul(out, in); // 11111111111
 
     return gf_sq(out); // 111111111110
+#else
+    gf tmp_111111;
+    int i;
+
+    out = gf_sq(tmp_1111);
+    out = gf_sq(out);
+    tmp_111111 = gf_mul(out, tmp_11); // 111111
+
+    out = tmp_111111;
+    for (i = 0; i < 6; i++) {
+        out = gf_sq(out);
+    }
+    out = gf_mul(out, tmp_111111); // 111111111111
+
+    return gf_sq(out); // 1111111111110
+#endif
 }
 
 /* input: field element den, num */
@@ -131,9 +156,24 @@ void GF_mul(gf *out, gf *in0, gf *in1) {
     //
 
     for (i = (SYS_T - 1) * 2; i >= SYS_T; i--) {
+#if MCELIECE_PARAMETER_SET == MCELIECE348864
+        /* y^64 + y^3 + y + z */
         prod[i - SYS_T + 3] ^= prod[i];
         prod[i - SYS_T + 1] ^= prod[i];
         prod[i - SYS_T + 0] ^= gf_mul(prod[i], (gf) 2);
+#elif MCELIECE_PARAMETER_SET == MCELIECE460896
+        /* y^96 + y^10 + y^9 + y^6 + 1 */
+        prod[i - SYS_T + 10] ^= prod[i];
+        prod[i - SYS_T + 9] ^= prod[i];
+        prod[i - SYS_T + 6] ^= prod[i];
+        prod[i - SYS_T + 0] ^= prod[i];
+#else
+        /* y^128 + y^7 + y^2 + y + 1 */
+        prod[i - SYS_T + 7] ^= prod[i];
+        prod[i - SYS_T + 2] ^= prod[i];
+        prod[i - SYS_T + 1] ^= prod[i];
+        prod[i - SYS_T + 0] ^= prod[i];
+#endif
     }
 
     for (i = 0; i < SYS_T; i++) {
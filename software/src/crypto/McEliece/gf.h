@@ -15,6 +15,17 @@
 
 #include <stdint.h>
 
+/*
+  When set, root and synd evaluate 64 field elements at a time using the
+  bitsliced arithmetic in vec.c.
+  Set to 0 to fall back to the one element at a time implementation.
+  The matrix fill of Versat_pk_gen always uses vec.c, since its bit planes
+  are the rows of the matrix.
+*/
+#ifndef GF_BITSLICED
+#define GF_BITSLICED 1
+#endif
+
 typedef uint16_t gf;
 
 gf gf_iszero(gf a);
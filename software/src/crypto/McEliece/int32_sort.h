@@ -1,5 +1,5 @@
-#ifndef PQCLEAN_MCELIECE348864_CLEAN_int32_sort_h
-#define PQCLEAN_MCELIECE348864_CLEAN_int32_sort_h
+#ifndef PQCLEAN_MCELIECE_CLEAN_int32_sort_h
+#define PQCLEAN_MCELIECE_CLEAN_int32_sort_h
 
 #include "namespace.h"
 
@@ -3,9 +3,42 @@
 
 #include "namespace.h"
 
+/*
+  Parameter sets. The one used is selected at compile time by defining
+  MCELIECE_PARAMETER_SET to one of these, mceliece348864 by default.
+*/
+#define MCELIECE348864  1
+#define MCELIECE460896  2
+#define MCELIECE6688128 3
+#define MCELIECE6960119 4
+#define MCELIECE8192128 5
+
+#ifndef MCELIECE_PARAMETER_SET
+#define MCELIECE_PARAMETER_SET MCELIECE348864
+#endif
+
+#if MCELIECE_PARAMETER_SET == MCELIECE348864
 #define GFBITS 12
 #define SYS_N 3488
 #define SYS_T 64
+#elif MCELIECE_PARAMETER_SET == MCELIECE460896
+#define GFBITS 13
+#define SYS_N 4608
+#define SYS_T 96
+#elif MCELIECE_PARAMETER_SET == MCELIECE6688128
+#define GFBITS 13
+#define SYS_N 6688
+#define SYS_T 128
+#elif MCELIECE_PARAMETER_SET == MCELIECE8192128
+#define GFBITS 13
+#define SYS_N 8192
+#define SYS_T 128
+#elif MCELIECE_PARAMETER_SET == MCELIECE6960119
+/* PK_NROWS = 1547 is not a multiple of 8, so the rows of the public key do not start on a byte boundary */
+#error "mceliece6960119 needs the unaligned public key rows of the reference implementation, which are not supported"
+#else
+#error "Unknown MCELIECE_PARAMETER_SET"
+#endif
 
 #define COND_BYTES ((1 << (GFBITS-4))*(2*GFBITS - 1))
 #define IRR_BYTES (SYS_T * 2)
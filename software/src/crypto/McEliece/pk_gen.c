@@ -41,7 +41,7 @@ int pk_gen(unsigned char *pk, unsigned char *sk, const uint32_t *perm, int16_t *
 
     int mark = MarkArena(globalArena);
 
-    uint64_t buf[ 1 << GFBITS ];
+    uint64_t* buf = PushArray(globalArena,1 << GFBITS,uint64_t);
 
     unsigned char** mat = PushAndZeroArray(globalArena,PK_NROWS,unsigned char*);
     for(int i = 0; i < PK_NROWS; i++){
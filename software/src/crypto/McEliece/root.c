@@ -5,6 +5,12 @@
 #include "root.h"
 #include "gf.h"
 #include "params.h"
+#include "vec.h"
+
+#ifdef VERSAT_ROOT
+/* The polynomial is evaluated by the HornerEval unit of the Versat accelerator */
+#include "versat_crypto.h"
+#endif
 
 /* input: polynomial f and field element a */
 /* return f(a) */
@@ -25,9 +31,26 @@ gf eval(gf *f, gf a) {
 /* input: polynomial f and list of field elements L */
 /* output: out = [ f(a) for a in L ] */
 void root(gf *out, gf *f, gf *L) {
+#ifdef VERSAT_ROOT
+    VersatRoot(out, f, L);
+#else
     int i;
 
+#if GF_BITSLICED
+    int n;
+    vec a[ GFBITS ], r[ GFBITS ];
+
+    for (i = 0; i < SYS_N; i += 64) {
+        n = (SYS_N - i < 64) ? SYS_N - i : 64;
+
+        vec_pack(a, L + i, n);
+        vec_eval(r, f, a);
+        vec_unpack(out + i, r, n);
+    }
+#else
     for (i = 0; i < SYS_N; i++) {
         out[i] = eval(f, L[i]);
     }
+#endif
+#endif
 }
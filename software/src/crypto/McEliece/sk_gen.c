@@ -15,6 +15,11 @@
 #include "printf.h"
 #include "arena.h"
 
+#ifdef VERSAT_GENPOLY
+/* The elimination runs on the Genpoly unit of the Versat accelerator */
+#include "versat_crypto.h"
+#endif
+
 static inline crypto_uint16 gf_is_zero_declassify(gf t) {
     crypto_uint16 mask = crypto_uint16_zero_mask(t);
     crypto_declassify(&mask, sizeof mask);
@@ -25,8 +30,7 @@ static inline crypto_uint16 gf_is_zero_declassify(gf t) {
 /* output: out, minimal polynomial of f */
 /* return: 0 for success and -1 for failure */
 int genpoly_gen(gf *out, gf *f) {
-    int i, j, k, c;
-    gf mask, inv, t;
+    int i, j;
 
     int mark = MarkArena(globalArena);
   
@@ -49,6 +53,15 @@ int genpoly_gen(gf *out, gf *f) {
         GF_mul(mat[j], mat[j - 1], f);
     }
 
+#ifdef VERSAT_GENPOLY
+    if (VersatGenpolySolve(out, mat)) {
+        PopArena(globalArena,mark);
+        return -1;
+    }
+#else
+    int k, c;
+    gf mask, inv, t;
+
     // gaussian
 
     for (j = 0; j < SYS_T; j++) {
@@ -86,6 +99,7 @@ int genpoly_gen(gf *out, gf *f) {
     for (i = 0; i < SYS_T; i++) {
         out[i] = mat[ SYS_T ][ i ];
     }
+#endif
 
     PopArena(globalArena,mark);
 
@@ -6,9 +6,45 @@
 
 #include "params.h"
 #include "root.h"
+#include "vec.h"
 
 /* input: Goppa polynomial f, support L, received word r */
 /* output: out, the syndrome of length 2t */
+#if GF_BITSLICED
+void synd(gf *out, gf *f, gf *L, const unsigned char *r) {
+    int i, j, k, n;
+    vec a[ GFBITS ], e[ GFBITS ], e_inv[ GFBITS ];
+    vec c;
+
+    for (j = 0; j < 2 * SYS_T; j++) {
+        out[j] = 0;
+    }
+
+    // SYS_N is a multiple of 8, so every block covers whole bytes of r
+    for (i = 0; i < SYS_N; i += 64) {
+        n = (SYS_N - i < 64) ? SYS_N - i : 64;
+
+        c = 0;
+        for (k = 0; k < n / 8; k++) {
+            c |= (vec) r[i / 8 + k] << (8 * k);
+        }
+
+        vec_pack(a, L + i, n);
+        vec_eval(e, f, a);
+        vec_sq(e, e);
+        vec_inv(e_inv, e);
+
+        for (k = 0; k < GFBITS; k++) {
+            e_inv[k] &= c;
+        }
+
+        for (j = 0; j < 2 * SYS_T; j++) {
+            out[j] ^= vec_sum(e_inv);
+            vec_mul(e_inv, e_inv, a);
+        }
+    }
+}
+#else
 void synd(gf *out, gf *f, gf *L, const unsigned char *r) {
     int i, j;
     gf e, e_inv, c;
@@ -29,3 +65,4 @@ void synd(gf *out, gf *f, gf *L, const unsigned char *r) {
         }
     }
 }
+#endif
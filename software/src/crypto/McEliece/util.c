@@ -62,5 +62,5 @@ gf bitrev(gf a) {
     a = ((a & 0x3333) << 2) | ((a & 0xCCCC) >> 2);
     a = ((a & 0x5555) << 1) | ((a & 0xAAAA) >> 1);
 
-    return a >> 4;
+    return a >> (16 - GFBITS);
 }
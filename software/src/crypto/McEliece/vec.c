@@ -0,0 +1,203 @@
+/*
+  This file is for bitsliced field arithmetic
+*/
+
+#include "vec.h"
+
+#include "params.h"
+#include "transpose.h"
+
+/* input: n <= 64 field elements in */
+/* output: out, the GFBITS bit planes of in (unused lanes are zero) */
+void vec_pack(vec *out, const gf *in, int n) {
+    int i;
+    uint64_t buf[64];
+
+    for (i = 0; i < 64; i++) {
+        buf[i] = (i < n) ? in[i] : 0;
+    }
+
+    transpose_64x64(buf, buf);
+
+    for (i = 0; i < GFBITS; i++) {
+        out[i] = buf[i];
+    }
+}
+
+/* input: GFBITS bit planes in */
+/* output: out, the first n field elements stored in the planes */
+void vec_unpack(gf *out, const vec *in, int n) {
+    int i;
+    uint64_t buf[64];
+
+    for (i = 0; i < 64; i++) {
+        buf[i] = (i < GFBITS) ? in[i] : 0;
+    }
+
+    transpose_64x64(buf, buf);
+
+    for (i = 0; i < n; i++) {
+        out[i] = (gf) buf[i];
+    }
+}
+
+/* input: field element a */
+/* output: out, a in every lane */
+void vec_set(vec *out, gf a) {
+    int i;
+
+    for (i = 0; i < GFBITS; i++) {
+        out[i] = -((vec) (a >> i) & 1);
+    }
+}
+
+/* input: field element a */
+/* output: out = out + a in every lane */
+void vec_add_gf(vec *out, gf a) {
+    int i;
+
+    for (i = 0; i < GFBITS; i++) {
+        out[i] ^= -((vec) (a >> i) & 1);
+    }
+}
+
+/* input: GFBITS bit planes in */
+/* return: the sum of all lanes of in */
+gf vec_sum(const vec *in) {
+    int i;
+    vec t;
+    gf ret = 0;
+
+    for (i = 0; i < GFBITS; i++) {
+        t = in[i];
+        t ^= t >> 32;
+        t ^= t >> 16;
+        t ^= t >> 8;
+        t ^= t >> 4;
+        t ^= t >> 2;
+        t ^= t >> 1;
+
+        ret |= (gf) ((t & 1) << i);
+    }
+
+    return ret;
+}
+
+/* input: buf, a product of degree 2*GFBITS-2 */
+/* output: out = buf mod the field polynomial */
+static void vec_reduce(vec *out, vec *buf) {
+    int i;
+
+    for (i = 2 * GFBITS - 2; i >= GFBITS; i--) {
+#if GFBITS == 12
+        /* x^12 + x^3 + 1 */
+        buf[i - GFBITS + 3] ^= buf[i];
+        buf[i - GFBITS + 0] ^= buf[i];
+#elif GFBITS == 13
+        /* x^13 + x^4 + x^3 + x + 1 */
+        buf[i - GFBITS + 4] ^= buf[i];
+        buf[i - GFBITS + 3] ^= buf[i];
+        buf[i - GFBITS + 1] ^= buf[i];
+        buf[i - GFBITS + 0] ^= buf[i];
+#endif
+    }
+
+    for (i = 0; i < GFBITS; i++) {
+        out[i] = buf[i];
+    }
+}
+
+/* input: f, g in bitsliced form */
+/* output: h = f * g (h may alias f or g) */
+void vec_mul(vec *h, const vec *f, const vec *g) {
+    int i, j;
+    vec buf[ 2 * GFBITS - 1 ];
+
+    for (i = 0; i < 2 * GFBITS - 1; i++) {
+        buf[i] = 0;
+    }
+
+    for (i = 0; i < GFBITS; i++) {
+        for (j = 0; j < GFBITS; j++) {
+            buf[i + j] ^= f[i] & g[j];
+        }
+    }
+
+    vec_reduce(h, buf);
+}
+
+/* input: in in bitsliced form */
+/* output: out = in^2 (out may alias in) */
+void vec_sq(vec *out, const vec *in) {
+    int i;
+    vec buf[ 2 * GFBITS - 1 ];
+
+    for (i = 0; i < 2 * GFBITS - 1; i++) {
+        buf[i] = 0;
+    }
+
+    for (i = 0; i < GFBITS; i++) {
+        buf[2 * i] = in[i];
+    }
+
+    vec_reduce(out, buf);
+}
+
+/* input: in in bitsliced form */
+/* output: out = in^-1, same addition chain as gf_inv (0 maps to 0) */
+void vec_inv(vec *out, const vec *in) {
+    vec tmp_11[ GFBITS ];
+    vec tmp_1111[ GFBITS ];
+
+    vec_sq(out, in);
+    vec_mul(tmp_11, out, in); // 11
+
+    vec_sq(out, tmp_11);
+    vec_sq(out, out);
+    vec_mul(tmp_1111, out, tmp_11); // 1111
+
+#if GFBITS == 12
+    vec_sq(out, tmp_1111);
+    vec_sq(out, out);
+    vec_sq(out, out);
+    vec_sq(out, out);
+    vec_mul(out, out, tmp_1111); // 11111111
+
+    vec_sq(out, out);
+    vec_sq(out, out);
+    vec_mul(out, out, tmp_11); // 1111111111
+
+    vec_sq(out, out);
+    vec_mul(out, out, in); // 11111111111
+
+    vec_sq(out, out); // 111111111110
+#else
+    vec tmp_111111[ GFBITS ];
+    int i;
+
+    vec_sq(out, tmp_1111);
+    vec_sq(out, out);
+    vec_mul(tmp_111111, out, tmp_11); // 111111
+
+    vec_sq(out, tmp_111111);
+    for (i = 1; i < 6; i++) {
+        vec_sq(out, out);
+    }
+    vec_mul(out, out, tmp_111111); // 111111111111
+
+    vec_sq(out, out); // 1111111111110
+#endif
+}
+
+/* input: polynomial f and 64 field elements a in bitsliced form */
+/* output: out = f(a) for every lane of a */
+void vec_eval(vec *out, const gf *f, const vec *a) {
+    int i;
+
+    vec_set(out, f[ SYS_T ]);
+
+    for (i = SYS_T - 1; i >= 0; i--) {
+        vec_mul(out, out, a);
+        vec_add_gf(out, f[i]);
+    }
+}
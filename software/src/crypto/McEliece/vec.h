@@ -0,0 +1,39 @@
+#ifndef VEC_H
+#define VEC_H
+/*
+  This file is for bitsliced field arithmetic.
+  A vec holds one bit plane of 64 field elements: bit j of plane i is bit i of element j.
+*/
+
+#include "namespace.h"
+
+#define vec_add_gf CRYPTO_NAMESPACE(vec_add_gf)
+#define vec_eval CRYPTO_NAMESPACE(vec_eval)
+#define vec_inv CRYPTO_NAMESPACE(vec_inv)
+#define vec_mul CRYPTO_NAMESPACE(vec_mul)
+#define vec_pack CRYPTO_NAMESPACE(vec_pack)
+#define vec_set CRYPTO_NAMESPACE(vec_set)
+#define vec_sq CRYPTO_NAMESPACE(vec_sq)
+#define vec_sum CRYPTO_NAMESPACE(vec_sum)
+#define vec_unpack CRYPTO_NAMESPACE(vec_unpack)
+
+#include "gf.h"
+
+#include <stdint.h>
+
+typedef uint64_t vec;
+
+void vec_pack(vec *out, const gf *in, int n);
+void vec_unpack(gf *out, const vec *in, int n);
+
+void vec_set(vec *out, gf a);
+void vec_add_gf(vec *out, gf a);
+gf vec_sum(const vec *in);
+
+void vec_mul(vec *h, const vec *f, const vec *g);
+void vec_sq(vec *out, const vec *in);
+void vec_inv(vec *out, const vec *in);
+
+void vec_eval(vec *out, const gf *f, const vec *a);
+
+#endif
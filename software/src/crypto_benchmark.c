@@ -0,0 +1,139 @@
+#include "crypto_benchmark.h"
+
+#include "printf.h"
+
+#include "crypto_tests.h"
+#include "crypto/sha2.h"
+#include "arena.h"
+
+Benchmark BenchmarkCreate(const char* name,int bytes,int capacity){
+  Benchmark bench = {};
+  bench.name = name;
+  bench.bytes = bytes;
+  bench.samples = PushArray(globalArena,capacity,uint32_t);
+  bench.capacity = capacity;
+
+  return bench;
+}
+
+void BenchmarkRecord(Benchmark* bench,uint32_t cycles){
+  if(bench->size < bench->capacity){
+    bench->samples[bench->size++] = cycles;
+  }
+}
+
+void BenchmarkRun(Benchmark* bench,BenchmarkFunction function,void* context,int warmup,int iterations){
+  for(int i = 0; i < warmup; i++){
+    function(context);
+  }
+
+  for(int i = 0; i < iterations; i++){
+    int start = GetTime();
+    function(context);
+    int end = GetTime();
+
+    BenchmarkRecord(bench,(uint32_t) (end - start));
+  }
+}
+
+// Benchmarks have at most a few hundred samples, an insertion sort is enough
+static void SortSamples(uint32_t* samples,int size){
+  for(int i = 1; i < size; i++){
+    uint32_t value = samples[i];
+    int j = i;
+    for(; j > 0 && samples[j - 1] > value; j--){
+      samples[j] = samples[j - 1];
+    }
+    samples[j] = value;
+  }
+}
+
+// Nearest rank: the smallest sample that is greater or equal to percent of the samples
+static uint32_t Percentile(uint32_t* sorted,int size,int percent){
+  int rank = (percent * size + 99) / 100;
+  if(rank < 1){
+    rank = 1;
+  }
+
+  return sorted[rank - 1];
+}
+
+BenchmarkStats BenchmarkComputeStats(Benchmark* bench){
+  SortSamples(bench->samples,bench->size);
+
+  BenchmarkStats stats = {};
+  stats.min = bench->samples[0];
+  stats.median = Percentile(bench->samples,bench->size,50);
+  stats.p90 = Percentile(bench->samples,bench->size,90);
+  stats.p99 = Percentile(bench->samples,bench->size,99);
+  stats.max = bench->samples[bench->size - 1];
+
+  return stats;
+}
+
+void BenchmarkPrintHeader(){
+  printf("  %-28s %7s %10s %10s %10s %10s %10s %12s\n","","samples","min","median","p90","p99","max","bytes/cycle");
+}
+
+void BenchmarkReport(Benchmark* bench){
+  if(bench->size == 0){
+    printf("  %-28s no samples\n",bench->name);
+    return;
+  }
+
+  BenchmarkStats stats = BenchmarkComputeStats(bench);
+
+  printf("  %-28s %7d %10u %10u %10u %10u %10u",bench->name,bench->size,(unsigned int) stats.min,(unsigned int) stats.median,(unsigned int) stats.p90,(unsigned int) stats.p99,(unsigned int) stats.max);
+
+  // The CPU has no floating point unit, so the throughput is printed with 3 fixed decimal places
+  if(bench->bytes > 0 && stats.median > 0){
+    uint32_t milli = (uint32_t) (((uint64_t) bench->bytes * 1000) / stats.median);
+    printf(" %8d.%03d\n",(int) (milli / 1000),(int) (milli % 1000));
+  } else {
+    printf(" %12s\n","-");
+  }
+}
+
+void BenchmarkFillInput(uint8_t* key,uint8_t* message,int size){
+  for(int i = 0; i < AES_KEY_SIZE; i++){
+    key[i] = (uint8_t) (i * 17 + 3);
+  }
+
+  for(int i = 0; i < size; i++){
+    message[i] = (uint8_t) (i * 7 + 1);
+  }
+}
+
+void SHAAESBenchmarkInit(SHAAESBenchmarkData* data,int maxSize){
+  *data = (SHAAESBenchmarkData){};
+  data->message = PushArray(globalArena,maxSize,uint8_t);
+  data->cypher = PushArray(globalArena,maxSize,uint8_t);
+
+  BenchmarkFillInput(data->key,data->message,maxSize);
+  AES_init_ctx(&data->ctx,data->key);
+}
+
+void BenchmarkVersatSHA(void* context){
+  SHAAESBenchmarkData* data = (SHAAESBenchmarkData*) context;
+  VersatSHA(data->digest,data->message,data->size);
+}
+
+void BenchmarkSoftwareSHA(void* context){
+  SHAAESBenchmarkData* data = (SHAAESBenchmarkData*) context;
+  sha256(data->digest,data->message,data->size);
+}
+
+void BenchmarkVersatAES(void* context){
+  SHAAESBenchmarkData* data = (SHAAESBenchmarkData*) context;
+  VersatAES256ECBSubmit(&data->aes,data->key,data->message,data->cypher,data->size / AES_BLK_SIZE);
+  VersatJobWait(&data->aes.job);
+}
+
+// Copies the message first, so that every iteration encrypts the same blocks
+void BenchmarkSoftwareAES(void* context){
+  SHAAESBenchmarkData* data = (SHAAESBenchmarkData*) context;
+  memcpy(data->cypher,data->message,data->size);
+  for(int i = 0; i < data->size; i += AES_BLK_SIZE){
+    AES_ECB_encrypt(&data->ctx,data->cypher + i);
+  }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "versat_crypto.h"
+#include "crypto/aes.h"
+
+/** \file
+ * Records the time of every iteration of a benchmark, so that the distribution of the times can be reported instead of only their average.
+ * A regression that only affects some of the iterations, like a retry or a cache miss, moves the tail of the distribution well before it moves the average.
+ */
+
+/**
+ * The samples of one benchmark, usually one algorithm at one input size.
+ */
+typedef struct{
+  //! Name printed in the report
+  const char* name;
+  //! Bytes processed by each iteration, used to compute the throughput. 0 if it does not apply
+  int bytes;
+  //! Time of each iteration, in cycles
+  uint32_t* samples;
+  //! Number of samples recorded
+  int size;
+  //! Number of samples that fit in samples
+  int capacity;
+} Benchmark;
+
+/**
+ * Computed from the samples of a benchmark. Percentiles use the nearest rank, so they are always one of the samples.
+ */
+typedef struct{
+  uint32_t min;
+  uint32_t median;
+  uint32_t p90;
+  uint32_t p99;
+  uint32_t max;
+} BenchmarkStats;
+
+/**
+ * \brief Function measured by BenchmarkRun
+ * \param context data given to BenchmarkRun
+ */
+typedef void (*BenchmarkFunction)(void* context);
+
+/**
+ * The samples are pushed to the global arena, so the caller pops them once the benchmark is reported.
+ * \brief Creates an empty benchmark
+ * \param name name printed in the report
+ * \param bytes bytes processed by each iteration, 0 if it does not apply
+ * \param capacity maximum number of samples
+ * \return the benchmark
+ */
+Benchmark BenchmarkCreate(const char* name,int bytes,int capacity);
+
+/**
+ * Samples past the capacity of the benchmark are dropped.
+ * \brief Records the time of one iteration
+ * \param bench the benchmark
+ * \param cycles time of the iteration, the difference between two values of GetTime
+ */
+void BenchmarkRecord(Benchmark* bench,uint32_t cycles);
+
+/**
+ * The warm-up iterations are not recorded. They pay for the instruction cache misses and for the initialization done by the first call of most Versat functions.
+ * \brief Times a function a number of times
+ * \param bench the benchmark
+ * \param function the function to time
+ * \param context data given to the function
+ * \param warmup iterations run before the recorded ones
+ * \param iterations iterations recorded
+ */
+void BenchmarkRun(Benchmark* bench,BenchmarkFunction function,void* context,int warmup,int iterations);
+
+/**
+ * Sorts the samples of the benchmark.
+ * \brief Computes the statistics of the samples
+ * \param bench the benchmark, with at least one sample
+ * \return the statistics
+ */
+BenchmarkStats BenchmarkComputeStats(Benchmark* bench);
+
+/**
+ * \brief Prints the header of the table printed by BenchmarkReport
+ */
+void BenchmarkPrintHeader();
+
+/**
+ * The throughput is computed from the median, in bytes per cycle.
+ * \brief Prints a line with the statistics of a benchmark
+ * \param bench the benchmark
+ */
+void BenchmarkReport(Benchmark* bench);
+
+/**
+ * Shared by the SHA and AES benchmarks, the tests that time Versat against software and the calibration of the dispatch, so that their times are comparable.
+ * \brief Fills a key and a message with the data used by the benchmarks
+ * \param key buffer of AES_KEY_SIZE bytes
+ * \param message buffer to fill
+ * \param size size of message in bytes
+ */
+void BenchmarkFillInput(uint8_t* key,uint8_t* message,int size);
+
+/**
+ * Context of the SHA and AES functions timed by the benchmarks. The caller sets size before timing them.
+ */
+typedef struct{
+  //! Hashed by the SHA functions and encrypted by the AES functions
+  uint8_t* message;
+  //! Where the AES functions store the encrypted message
+  uint8_t* cypher;
+  //! Bytes of message processed, a multiple of AES_BLK_SIZE for the AES functions
+  int size;
+  //! Where the SHA functions store the digest
+  uint8_t digest[SHA_DIGEST_SIZE];
+  uint8_t key[AES_KEY_SIZE];
+  //! Key expanded for the software AES
+  struct AES_ctx ctx;
+  //! Used by the Versat AES function. The key stays the same, so only the first iteration expands it
+  VersatAESJob aes;
+} SHAAESBenchmarkData;
+
+/**
+ * The message and cypher buffers are pushed to the global arena. InitVersatSHA still needs to be called before timing the Versat SHA function.
+ * \brief Prepares the context of the SHA and AES functions
+ * \param data the context
+ * \param maxSize largest size that will be timed
+ */
+void SHAAESBenchmarkInit(SHAAESBenchmarkData* data,int maxSize);
+
+//! Hashes the message with VersatSHA, context is a SHAAESBenchmarkData
+void BenchmarkVersatSHA(void* context);
+
+//! Hashes the message with the software sha256, context is a SHAAESBenchmarkData
+void BenchmarkSoftwareSHA(void* context);
+
+//! Encrypts the message with VersatAES256ECBSubmit and waits for it, context is a SHAAESBenchmarkData
+void BenchmarkVersatAES(void* context);
+
+//! Encrypts the message with tiny-AES, context is a SHAAESBenchmarkData
+void BenchmarkSoftwareAES(void* context);
@@ -6,6 +6,8 @@
 
 #include "versat_accel.h"
 #include "versat_crypto.h"
+#include "versat_shadow.h"
+#include "crypto_benchmark.h"
 #include "crypto/aes.h"
 #include "crypto/sha2.h"
 
@@ -14,6 +16,7 @@
 
 void InitializeCryptoSide(int versatAddress){
   versat_init(versatAddress);
+  ShadowInvalidate(); // Values written before the accelerator was initialized are not known
   ConfigEnableDMA(true); // No problem using DMA in embedded.
 }
 
@@ -85,7 +88,9 @@ TestState VersatCommonSHATests(String content){
       break;
     }
 
-    char* expected = ptr;
+    // The expected digest is decoded in place, the next record is searched after its characters
+    unsigned char* expected = (unsigned char*) ptr;
+    ptr += HexStringToHex((char*) expected,ptr) * 2;
 
     unsigned char versat_digest[32];
     unsigned char software_digest[32];
@@ -100,26 +105,22 @@ TestState VersatCommonSHATests(String content){
     sha256(software_digest,message,len / 8);
     int end = GetTime();
 
-    bool good = true;
-    for(int i = 0; i < 32; i++){
-      if(versat_digest[i] != software_digest[i]){
-        good = false;
-        break;
-      }
-    }
+    bool good = (memcmp(versat_digest,expected,HASH_SIZE) == 0 && memcmp(software_digest,expected,HASH_SIZE) == 0);
 
     if(good){
       result.versatTimeAccum += middle - start;
       result.softwareTimeAccum += end - middle;
       result.goodTests += 1;
     } else {
+      char expected_buffer[256];
       char versat_buffer[256];
       char software_buffer[256];
+      GetHexadecimal((char*) expected,expected_buffer, HASH_SIZE);
       GetHexadecimal((char*) versat_digest,versat_buffer, HASH_SIZE);
       GetHexadecimal((char*) software_digest,software_buffer, HASH_SIZE);
 
       printf("SHA Test %02d: Error\n",result.tests);
-      printf("  Expected: %.64s\n",expected); 
+      printf("  Expected: %s\n",expected_buffer); 
       printf("  Software: %s\n",software_buffer);
       printf("  Versat:   %s\n",versat_buffer);
     }
@@ -180,7 +181,9 @@ TestState VersatCommonAESTests(String content){
       break;
     }
 
-    char* cypher = ptr;
+    // The expected result is decoded in place, the next record is searched after its characters
+    unsigned char* cypher = (unsigned char*) ptr;
+    ptr += HexStringToHex((char*) cypher,ptr) * 2;
 
     uint8_t versat_result[AES_BLK_SIZE] = {};
     uint8_t software_result[AES_BLK_SIZE] = {};
@@ -195,26 +198,22 @@ TestState VersatCommonAESTests(String content){
     AES_ECB_encrypt(&ctx,software_result);
     int end = GetTime();
 
-    bool good = true;
-    for(int i = 0; i < AES_BLK_SIZE; i++){
-      if(versat_result[i] != software_result[i]){
-        good = false;
-        break;
-      }
-    }
+    bool good = (memcmp(versat_result,cypher,AES_BLK_SIZE) == 0 && memcmp(software_result,cypher,AES_BLK_SIZE) == 0);
 
     if(good){
       result.versatTimeAccum += middle - start;
       result.softwareTimeAccum += end - middle;
       result.goodTests += 1;
     } else {
+      char expected_buffer[256];
       char versat_buffer[256];
       char software_buffer[256];
+      GetHexadecimal((char*) cypher,expected_buffer, AES_BLK_SIZE);
       GetHexadecimal((char*) versat_result,versat_buffer, AES_BLK_SIZE);
       GetHexadecimal((char*) software_result,software_buffer, AES_BLK_SIZE);
 
       printf("AES Test %02d: Error\n",result.tests);
-      printf("  Expected: %.32s\n",cypher); 
+      printf("  Expected: %s\n",expected_buffer); 
       printf("  Software: %s\n",software_buffer);
       printf("  Versat:   %s\n",versat_buffer);
     }
@@ -228,23 +227,154 @@ TestState VersatCommonAESTests(String content){
   return result;
 }
 
-static char GetHexadecimalChar(unsigned char value){
-  if(value < 10){
-    return '0' + value;
-  } else{
-    return 'A' + (value - 10);
+// Times both functions at the current size of data, prints a line of the table and returns true if Versat was faster
+static bool SweepSize(const char* name,SHAAESBenchmarkData* data,BenchmarkFunction versatFunction,BenchmarkFunction softwareFunction,int iterations){
+  static const int WARMUP = 1;
+
+  int mark = MarkArena(globalArena);
+
+  Benchmark versat = BenchmarkCreate(name,data->size,iterations);
+  Benchmark software = BenchmarkCreate(name,data->size,iterations);
+  BenchmarkRun(&versat,versatFunction,data,WARMUP,iterations);
+  BenchmarkRun(&software,softwareFunction,data,WARMUP,iterations);
+
+  BenchmarkStats versatStats = BenchmarkComputeStats(&versat);
+  BenchmarkStats softwareStats = BenchmarkComputeStats(&software);
+
+  printf("%s,%d,%u,%u,%u,%u\n",name,data->size,(unsigned int) versatStats.min,(unsigned int) versatStats.median,
+                                                (unsigned int) softwareStats.min,(unsigned int) softwareStats.median);
+
+  PopArena(globalArena,mark);
+
+  return versatStats.median < softwareStats.median;
+}
+
+// The crossover is the smallest size from which Versat is faster for every size of the sweep
+static void PrintCrossover(const char* name,int crossover){
+  if(crossover < 0){
+    printf("  %s: software is faster for every size\n",name);
+  } else {
+    printf("  %s: Versat is faster from %d bytes\n",name,crossover);
+  }
+}
+
+int VersatCommonSweepBenchmark(int iterations){
+  if(iterations <= 0){
+    return 0;
+  }
+
+  static const int MAX_SIZE = 64 * 1024;
+
+  int mark = MarkArena(globalArena);
+
+  SHAAESBenchmarkData data;
+  SHAAESBenchmarkInit(&data,MAX_SIZE);
+
+  InitVersatSHA();
+
+  int errors = 0;
+  int shaCrossover = -1;
+  int aesCrossover = -1;
+
+  // Between markers so that the table can be cut from the log and read as CSV
+  printf("\n\n=======================================================\n");
+  printf("Length sweep, median of %d iterations in cycles (not seconds)\n",iterations);
+  printf("---- BEGIN CSV ----\n");
+  printf("algorithm,bytes,versat_min,versat_median,software_min,software_median\n");
+
+  for(int size = 0; size <= MAX_SIZE; size = (size == 0) ? 1 : size * 2){
+    data.size = size;
+
+    uint8_t versat_digest[SHA_DIGEST_SIZE];
+    bool faster = SweepSize("sha256",&data,BenchmarkVersatSHA,BenchmarkSoftwareSHA,iterations);
+    VersatSHA(versat_digest,data.message,size);
+    sha256(data.digest,data.message,size);
+    if(memcmp(versat_digest,data.digest,SHA_DIGEST_SIZE) != 0){
+      errors += 1;
+    }
+
+    if(!faster){
+      shaCrossover = -1;
+    } else if(shaCrossover < 0){
+      shaCrossover = size;
+    }
+  }
+
+  for(int size = AES_BLK_SIZE; size <= MAX_SIZE; size *= 2){
+    data.size = size;
+
+    bool faster = SweepSize("aes256_ecb",&data,BenchmarkVersatAES,BenchmarkSoftwareAES,iterations);
+
+    // The software cypher is the last one written to the buffer, it is compared to the versat one
+    int testMark = MarkArena(globalArena);
+    uint8_t* software_cypher = PushArray(globalArena,size,uint8_t);
+    memcpy(software_cypher,data.cypher,size);
+    BenchmarkVersatAES(&data);
+    if(memcmp(software_cypher,data.cypher,size) != 0){
+      errors += 1;
+    }
+    PopArena(globalArena,testMark);
+
+    if(!faster){
+      aesCrossover = -1;
+    } else if(aesCrossover < 0){
+      aesCrossover = size;
+    }
+  }
+
+  printf("---- END CSV ----\n\n");
+  PrintCrossover("sha256",shaCrossover);
+  PrintCrossover("aes256_ecb",aesCrossover);
+  if(errors){
+    printf("  %d sizes where Versat and software results differ\n",errors);
   }
+  printf("=======================================================\n\n");
+
+  PopArena(globalArena,mark);
+
+  return errors ? 1 : 0;
 }
 
+// The two hexadecimal characters of every byte value, so that a byte is encoded with a single lookup
+static const char hexPairs[512] =
+  "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+  "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+  "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+  "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+  "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+  "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+  "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+  "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+// Value of each character as an hexadecimal digit plus one. Zero for characters that are not hexadecimal digits
+static const uint8_t hexDigit[256] = {
+  ['0'] = 1,['1'] = 2,['2'] = 3,['3'] = 4,['4'] = 5,['5'] = 6,['6'] = 7,['7'] = 8,['8'] = 9,['9'] = 10,
+  ['a'] = 11,['b'] = 12,['c'] = 13,['d'] = 14,['e'] = 15,['f'] = 16,
+  ['A'] = 11,['B'] = 12,['C'] = 13,['D'] = 14,['E'] = 15,['F'] = 16
+};
+
 /**
  *  Given a bunch of bytes, computes the hexadecimal representation and stores it in buffer.
  */
 char* GetHexadecimal(const char* text,char* buffer,int str_size){
+  const uint8_t* view = (const uint8_t*) text;
+
   int i = 0;
-  unsigned char* view = (unsigned char*) text;
-  for(; i< str_size; i++){
-    buffer[i*2] = GetHexadecimalChar(view[i] / 16);
-    buffer[i*2+1] = GetHexadecimalChar(view[i] % 16);
+  for(; i + 4 <= str_size; i += 4){
+    const char* p0 = &hexPairs[view[i] * 2];
+    const char* p1 = &hexPairs[view[i+1] * 2];
+    const char* p2 = &hexPairs[view[i+2] * 2];
+    const char* p3 = &hexPairs[view[i+3] * 2];
+
+    char* out = &buffer[i*2];
+    out[0] = p0[0]; out[1] = p0[1];
+    out[2] = p1[0]; out[3] = p1[1];
+    out[4] = p2[0]; out[5] = p2[1];
+    out[6] = p3[0]; out[7] = p3[1];
+  }
+  for(; i < str_size; i++){
+    buffer[i*2] = hexPairs[view[i] * 2];
+    buffer[i*2+1] = hexPairs[view[i] * 2 + 1];
   }
 
   buffer[i*2] = '\0';
@@ -252,36 +382,46 @@ char* GetHexadecimal(const char* text,char* buffer,int str_size){
   return buffer;
 }
 
-static char HexToInt(char ch){
-   if('0' <= ch && ch <= '9'){
-      return (ch - '0');
-   } else if('a' <= ch && ch <= 'f'){
-      return ch - 'a' + 10;
-   } else if('A' <= ch && ch <= 'F'){
-      return ch - 'A' + 10;
-   } else {
-      return 0x7f;
-   }
+static uint8_t HexPairValue(const uint8_t* str){
+  return (uint8_t) ((hexDigit[str[0]] - 1) * 16 + (hexDigit[str[1]] - 1));
 }
 
 /**
- *  Given a string of hexadecimal characters, converts them into bytes
+ *  Given a string of hexadecimal characters, converts them into bytes.
+ *  The length of the string is found first, so that the conversion itself needs no checks and handles four bytes at a time.
+ *  Each group of characters is read before its bytes are written, so buffer can be str itself.
  */
 int HexStringToHex(char* buffer,const char* str){
-   int inserted = 0;
-   for(int i = 0; ; i += 2){
-      char upper = HexToInt(str[i]);
-      char lower = HexToInt(str[i+1]);
-
-      if(upper >= 16 || lower >= 16){
-         if(upper < 16){ // Upper is good but lower is not
-            printf("Warning: HexString was not divisible by 2\n");
-         }
-         break;
-      }
-
-      buffer[inserted++] = upper * 16 + lower;
-   }
-
-   return inserted;
+  const uint8_t* view = (const uint8_t*) str;
+  uint8_t* out = (uint8_t*) buffer;
+
+  int size = 0;
+  while(hexDigit[view[size]]){
+    size += 1;
+  }
+
+  if(size % 2 == 1){
+    printf("Warning: HexString was not divisible by 2\n");
+  }
+
+  int bytes = size / 2;
+
+  int i = 0;
+  for(; i + 4 <= bytes; i += 4){
+    const uint8_t* p = &view[i*2];
+    uint8_t b0 = HexPairValue(p);
+    uint8_t b1 = HexPairValue(p + 2);
+    uint8_t b2 = HexPairValue(p + 4);
+    uint8_t b3 = HexPairValue(p + 6);
+
+    out[i] = b0;
+    out[i+1] = b1;
+    out[i+2] = b2;
+    out[i+3] = b3;
+  }
+  for(; i < bytes; i++){
+    out[i] = HexPairValue(&view[i*2]);
+  }
+
+  return bytes;
 }
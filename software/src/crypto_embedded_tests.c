@@ -6,10 +6,14 @@
 #include "iob-uart.h"
 
 #include "versat_crypto.h"
+#include "crypto_benchmark.h"
+#include "crypto/aes.h"
+#include "crypto/sha2.h"
 
 // McEliece
 #include "api.h"
 #include "arena.h"
+#include "root.h"
 
 /**
  * This function was obtained from the PQClean repository. It is used when running McEliece because only a small portion of McEliece is speedup by Versat.
@@ -35,6 +39,197 @@ String PushFile(const char* filepath){
   return (String){.str=testFile,.size=file_size};
 }
 
+// The reader is only used by the McEliece KAT, which only covers mceliece348864
+#if MCELIECE_PARAMETER_SET == MCELIECE348864
+
+// Size of the ring buffer of the KAT reader, a power of two
+#define KAT_READER_SIZE 4096
+#define KAT_READER_MASK (KAT_READER_SIZE - 1)
+
+// Bytes decoded at a time when hashing a field of the KAT, a multiple of the SHA-256 block size
+#define KAT_READER_CHUNK 256
+
+/**
+ * Reads a KAT file from the host through a ring buffer, so that files much bigger than the memory of the SoC can be parsed.
+ * The host sends the file without flow control, so between KatReaderOpen and KatReaderClose the parser has to keep up with the UART
+ * and nothing slow, like a key generation, can run.
+ */
+typedef struct{
+  //! Last bytes received, indexed by their position in the file
+  char buffer[KAT_READER_SIZE];
+  //! Size of the file sent by the host
+  uint32_t fileSize;
+  //! Bytes received from the host
+  uint32_t received;
+  //! Bytes consumed by the parser. The ones between consumed and received are still in the buffer
+  uint32_t consumed;
+} KatReader;
+
+/**
+ * Uses the same protocol as uart_recvfile but does not receive the content.
+ * \brief Requests a file from the host
+ * \param reader the reader to initialize
+ * \param filepath C-Style string that contains the filepath on the host side
+ */
+static void KatReaderOpen(KatReader* reader,const char* filepath){
+  uart_putc(FRX);
+  uart_puts((char*) filepath);
+  uart_putc(0);
+
+  uint32_t fileSize = 0;
+  for(int i = 0; i < 4; i++){
+    fileSize |= ((uint32_t) (uint8_t) uart_getc()) << (i * 8);
+  }
+
+  uart_putc(ACK);
+
+  reader->fileSize = fileSize;
+  reader->received = 0;
+  reader->consumed = 0;
+}
+
+// Receives bytes until the buffer is full or the file ends
+static void KatReaderFill(KatReader* reader){
+  while(reader->received - reader->consumed < KAT_READER_SIZE && reader->received < reader->fileSize){
+    reader->buffer[reader->received & KAT_READER_MASK] = uart_getc();
+    reader->received += 1;
+  }
+}
+
+// Returns the next byte without consuming it, or -1 at the end of the file
+static int KatReaderPeek(KatReader* reader){
+  if(reader->consumed == reader->received){
+    KatReaderFill(reader);
+    if(reader->consumed == reader->received){
+      return -1;
+    }
+  }
+
+  return (uint8_t) reader->buffer[reader->consumed & KAT_READER_MASK];
+}
+
+/**
+ * The values searched for do not repeat their first character, so a mismatch only needs to restart the match.
+ * \brief Streaming version of SearchAndAdvance
+ * \param reader the reader
+ * \param str value that we are searching for
+ * \return true if str was found, the reader is then past it. False at the end of the file
+ */
+static bool KatReaderSearch(KatReader* reader,String str){
+  int matched = 0;
+  while(matched < str.size){
+    int ch = KatReaderPeek(reader);
+    if(ch < 0){
+      return false;
+    }
+    reader->consumed += 1;
+
+    if(ch == str.str[matched]){
+      matched += 1;
+    } else {
+      matched = (ch == str.str[0]) ? 1 : 0;
+    }
+  }
+
+  return true;
+}
+
+static bool IsHexCharacter(int ch){
+  return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+}
+
+/**
+ * \brief Decodes the hexadecimal value that follows in the file
+ * \param reader the reader
+ * \param out buffer where the bytes are stored
+ * \param maxBytes size of out. The value is decoded up to maxBytes, the rest is left in the file
+ * \return the number of bytes decoded
+ */
+static int KatReaderHex(KatReader* reader,char* out,int maxBytes){
+  char text[2 * KAT_READER_CHUNK + 1];
+
+  int bytes = 0;
+  while(bytes < maxBytes){
+    int chunk = maxBytes - bytes;
+    if(chunk > KAT_READER_CHUNK){
+      chunk = KAT_READER_CHUNK;
+    }
+
+    int size = 0;
+    while(size < chunk * 2){
+      int ch = KatReaderPeek(reader);
+      if(!IsHexCharacter(ch)){
+        break;
+      }
+      text[size++] = (char) ch;
+      reader->consumed += 1;
+    }
+    text[size] = '\0';
+
+    bytes += HexStringToHex(&out[bytes],text);
+    if(size < chunk * 2){
+      break;
+    }
+  }
+
+  return bytes;
+}
+
+/**
+ * The field is decoded a chunk at a time and hashed, so only KAT_READER_CHUNK bytes of it are kept in memory.
+ * Hashing keeps up with the UART, unlike the key generation that produces the value to compare with.
+ * \brief Computes the SHA-256 of the hexadecimal value that follows in the file
+ * \param reader the reader
+ * \param digest buffer to store the SHA_DIGEST_SIZE bytes of the hash
+ * \param size expected size of the value in bytes
+ * \return true if the value has size bytes
+ */
+static bool KatReaderDigest(KatReader* reader,uint8_t* digest,int size){
+  uint8_t value[KAT_READER_CHUNK];
+
+  sha256ctx state;
+  sha256_inc_init(&state);
+
+  // Every chunk but the last one is a whole number of SHA-256 blocks
+  int offset = 0;
+  int bytes = 0;
+  while(1){
+    int chunk = size - offset;
+    if(chunk > KAT_READER_CHUNK){
+      chunk = KAT_READER_CHUNK;
+    }
+
+    bytes = KatReaderHex(reader,(char*) value,chunk);
+    if(bytes < KAT_READER_CHUNK || offset + bytes == size){
+      break;
+    }
+
+    sha256_inc_blocks(&state,value,KAT_READER_CHUNK / 64);
+    offset += bytes;
+  }
+
+  sha256_inc_finalize(digest,&state,value,bytes);
+  offset += bytes;
+
+  // The value is shorter or longer than expected
+  return (offset == size && !IsHexCharacter(KatReaderPeek(reader)));
+}
+
+/**
+ * The host sends the whole file, so the bytes that were not parsed still need to be received before the UART is used for anything else.
+ * \brief Receives the rest of the file
+ * \param reader the reader
+ */
+static void KatReaderClose(KatReader* reader){
+  while(reader->received < reader->fileSize){
+    uart_getc();
+    reader->received += 1;
+  }
+  reader->consumed = reader->received;
+}
+
+#endif
+
 int VersatSHATests(){
   int mark = MarkArena(globalArena);
   String content = PushFile("../../software/KAT/SHA256ShortMsg.rsp");
@@ -83,130 +278,591 @@ int VersatAESTests(){
   return (result.goodTests == result.tests) ? 0 : 1;
 }
 
-int VersatMcElieceTests(){
+int VersatMixedSHAAESTests(){
   int mark = MarkArena(globalArena);
 
-  unsigned char* public_key = PushArray(globalArena,PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_PUBLICKEYBYTES,unsigned char);
-  unsigned char* secret_key = PushArray(globalArena,PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_SECRETKEYBYTES,unsigned char);
+  // A SHA block takes one run and an AES-256 block takes 15, so both jobs take about the same number of runs
+  static const int MESSAGE_SIZE = 4096;
+  static const int AES_BLOCKS = 4;
 
-  int versatTimeAccum = 0;
+  uint8_t key[AES_KEY_SIZE];
+  uint8_t* message = PushArray(globalArena,MESSAGE_SIZE,uint8_t);
+  BenchmarkFillInput(key,message,MESSAGE_SIZE);
+
+  uint8_t* plain = PushArray(globalArena,AES_BLOCKS * AES_BLK_SIZE,uint8_t);
+  for(int i = 0; i < AES_BLOCKS * AES_BLK_SIZE; i++){
+    plain[i] = (uint8_t) (i * 13 + 5);
+  }
+
+  uint8_t* versat_cypher = PushArray(globalArena,AES_BLOCKS * AES_BLK_SIZE,uint8_t);
+  uint8_t* software_cypher = PushArray(globalArena,AES_BLOCKS * AES_BLK_SIZE,uint8_t);
+  uint8_t versat_digest[SHA_DIGEST_SIZE];
+  uint8_t software_digest[SHA_DIGEST_SIZE];
+
+  VersatSHAJob sha;
+  VersatAESJob aes;
+
+  InitVersatSHA();
+
+  // Expand the key beforehand, so that both measurements do the same work
+  VersatAES256ECBSubmit(&aes,key,plain,versat_cypher,1);
+  VersatJobWait(&aes.job);
+
+  int start = GetTime();
+  VersatSHASubmit(&sha,versat_digest,message,MESSAGE_SIZE);
+  VersatJobWait(&sha.job);
+  VersatAES256ECBSubmit(&aes,key,plain,versat_cypher,AES_BLOCKS);
+  VersatJobWait(&aes.job);
+  int middle = GetTime();
+  VersatSHASubmit(&sha,versat_digest,message,MESSAGE_SIZE);
+  VersatAES256ECBSubmit(&aes,key,plain,versat_cypher,AES_BLOCKS);
+  VersatJobWaitAll();
+  int end = GetTime();
+
+  sha256(software_digest,message,MESSAGE_SIZE);
+
+  struct AES_ctx ctx;
+  AES_init_ctx(&ctx,key);
+  memcpy(software_cypher,plain,AES_BLOCKS * AES_BLK_SIZE);
+  for(int i = 0; i < AES_BLOCKS; i++){
+    AES_ECB_encrypt(&ctx,software_cypher + i * AES_BLK_SIZE);
+  }
+
+  bool good = (memcmp(versat_digest,software_digest,SHA_DIGEST_SIZE) == 0 &&
+               memcmp(versat_cypher,software_cypher,AES_BLOCKS * AES_BLK_SIZE) == 0);
 
-  String content = PushFile("../../software/KAT/McElieceRound4kat_kem_short.rsp");
+  printf("\n\n=======================================================\n");
+  printf("Mixed SHA and AES test: %s\n\n",good ? "OK" : "Error");
+  printf("  Cycles for a %d byte SHA and %d AES blocks (not seconds)\n",MESSAGE_SIZE,AES_BLOCKS);
+  printf("  One after the other: %-7d\n",middle - start);
+  printf("     Sharing the runs: %-7d\n",end - middle);
+  printf("=======================================================\n\n");
 
-  char* ptr = content.str;
+  PopArena(globalArena,mark);
+  return good ? 0 : 1;
+}
+
+/**
+ * Used for the key generation variants and parameter sets that have no KAT.
+ * \brief Generates keys and checks them by encapsulating and decapsulating a secret
+ * \param name printed in the results
+ * \param keypair the key generation function to test
+ * \return 0 if successful, 1 otherwise
+ */
+static int McElieceRoundTripTests(const char* name,void (*keypair)(unsigned char*,unsigned char*)){
+  int mark = MarkArena(globalArena);
+
+  unsigned char* public_key = PushAlignedArray(globalArena,VERSAT_MCELIECE_PK_BUFFER_SIZE,unsigned char,VERSAT_MCELIECE_PK_BUFFER_ALIGN);
+  unsigned char* secret_key = PushArray(globalArena,PQCLEAN_MCELIECE_CLEAN_CRYPTO_SECRETKEYBYTES,unsigned char);
+
+  unsigned char ciphertext[PQCLEAN_MCELIECE_CLEAN_CRYPTO_CIPHERTEXTBYTES];
+  unsigned char encapsulated[PQCLEAN_MCELIECE_CLEAN_CRYPTO_BYTES];
+  unsigned char decapsulated[PQCLEAN_MCELIECE_CLEAN_CRYPTO_BYTES];
+
+  unsigned char seed[48];
+  for(int i = 0; i < 48; i++){
+    seed[i] = i;
+  }
+  nist_kat_init(seed, NULL, 256);
+
+  int versatTimeAccum = 0;
   int goodTests = 0;
-  int tests = 0;
-  while(1){
-    int testMark = MarkArena(globalArena);
+  int tests = 2;
+  for(int i = 0; i < tests; i++){
+    int start = GetTime();
+    keypair(public_key, secret_key);
+    int end = GetTime();
 
-    ptr = SearchAndAdvance(ptr,STRING("COUNT = "));
-    if(ptr == NULL){
-      break;
+    PQCLEAN_MCELIECE_CLEAN_crypto_kem_enc(ciphertext,encapsulated,public_key);
+    PQCLEAN_MCELIECE_CLEAN_crypto_kem_dec(decapsulated,ciphertext,secret_key);
+
+    if(memcmp(encapsulated,decapsulated,PQCLEAN_MCELIECE_CLEAN_CRYPTO_BYTES) == 0){
+      versatTimeAccum += end - start;
+      goodTests += 1;
+    } else {
+      printf("%s Test %02d: Error\n",name,i);
+      printf("  Encapsulated secret does not match decapsulated secret\n");
     }
+  }
+
+  printf("\n\n=======================================================\n");
+  printf("%s tests: %d passed out of %d\n",name,goodTests,tests);
+  printf("  Versat key generation: %d\n",versatTimeAccum);
+  printf("=======================================================\n\n");
+  PopArena(globalArena,mark);
 
-    int count = ParseNumber(ptr);
+  return (goodTests == tests) ? 0 : 1;
+}
 
-    ptr = SearchAndAdvance(ptr,STRING("SEED = "));
-    if(ptr == NULL){
-      printf("McEliece early exit 1. Something wrong with testfile\n");
-      break;
+// Compares crypto_sha256 and crypto_aes256_ecb_encrypt with the software implementations for a few sizes around the block boundaries
+static int CheckDispatch(const uint8_t* key,const uint8_t* message,uint8_t* versat_cypher,uint8_t* software_cypher){
+  static const int SHA_SIZES[] = {0,1,55,56,64,65,1000,4096};
+  static const int AES_BLOCKS[] = {1,2,5,64};
+
+  int errors = 0;
+  for(int i = 0; i < (int) (sizeof(SHA_SIZES) / sizeof(SHA_SIZES[0])); i++){
+    uint8_t dispatch_digest[SHA_DIGEST_SIZE];
+    uint8_t software_digest[SHA_DIGEST_SIZE];
+    crypto_sha256(dispatch_digest,message,SHA_SIZES[i]);
+    sha256(software_digest,message,SHA_SIZES[i]);
+    if(memcmp(dispatch_digest,software_digest,SHA_DIGEST_SIZE) != 0){
+      printf("  SHA of %d bytes differs from software\n",SHA_SIZES[i]);
+      errors += 1;
     }
+  }
+
+  struct AES_ctx ctx;
+  AES_init_ctx(&ctx,key);
+  for(int i = 0; i < (int) (sizeof(AES_BLOCKS) / sizeof(AES_BLOCKS[0])); i++){
+    int size = AES_BLOCKS[i] * AES_BLK_SIZE;
+    crypto_aes256_ecb_encrypt(key,message,versat_cypher,AES_BLOCKS[i]);
+    memcpy(software_cypher,message,size);
+    for(int j = 0; j < size; j += AES_BLK_SIZE){
+      AES_ECB_encrypt(&ctx,software_cypher + j);
+    }
+    if(memcmp(versat_cypher,software_cypher,size) != 0){
+      printf("  AES of %d blocks differs from software\n",AES_BLOCKS[i]);
+      errors += 1;
+    }
+  }
+
+  return errors;
+}
+
+int VersatDispatchTests(){
+  int mark = MarkArena(globalArena);
+
+  static const int MESSAGE_SIZE = 4096;
+
+  uint8_t key[AES_KEY_SIZE];
+  for(int i = 0; i < AES_KEY_SIZE; i++){
+    key[i] = (uint8_t) (i * 5 + 11);
+  }
+
+  uint8_t* message = PushArray(globalArena,MESSAGE_SIZE,uint8_t);
+  for(int i = 0; i < MESSAGE_SIZE; i++){
+    message[i] = (uint8_t) (i * 3 + 2);
+  }
+  uint8_t* versat_cypher = PushArray(globalArena,MESSAGE_SIZE,uint8_t);
+  uint8_t* software_cypher = PushArray(globalArena,MESSAGE_SIZE,uint8_t);
+
+  int start = GetTime();
+  CryptoDispatchThresholds calibrated = CryptoDispatchCalibrate();
+  int end = GetTime();
+
+  // Every size goes through both paths, then through the calibrated thresholds
+  int errors = 0;
+  CryptoDispatchSetThresholds((CryptoDispatchThresholds){0,0});
+  errors += CheckDispatch(key,message,versat_cypher,software_cypher);
+  CryptoDispatchSetThresholds((CryptoDispatchThresholds){SIZE_MAX,SIZE_MAX});
+  errors += CheckDispatch(key,message,versat_cypher,software_cypher);
+  CryptoDispatchSetThresholds(calibrated);
+  errors += CheckDispatch(key,message,versat_cypher,software_cypher);
+
+  // While a SHA job is queued, crypto_sha256 uses software instead of waiting for it
+  CryptoDispatchSetThresholds((CryptoDispatchThresholds){0,0});
+  VersatSHAJob sha;
+  uint8_t job_digest[SHA_DIGEST_SIZE];
+  uint8_t dispatch_digest[SHA_DIGEST_SIZE];
+  uint8_t software_digest[SHA_DIGEST_SIZE];
+  VersatSHASubmit(&sha,job_digest,message,MESSAGE_SIZE);
+  crypto_sha256(dispatch_digest,message,MESSAGE_SIZE);
+  bool busy = !VersatJobDone(&sha.job);
+  VersatJobWait(&sha.job);
+  sha256(software_digest,message,MESSAGE_SIZE);
+  if(memcmp(job_digest,software_digest,SHA_DIGEST_SIZE) != 0 || memcmp(dispatch_digest,software_digest,SHA_DIGEST_SIZE) != 0){
+    printf("  SHA while the accelerator is busy differs from software\n");
+    errors += 1;
+  }
+
+  // An IV loaded for CBC must not be chained into the blocks of ECB
+  uint8_t iv[AES_BLK_SIZE];
+  for(int i = 0; i < AES_BLK_SIZE; i++){
+    iv[i] = (uint8_t) (i * 9 + 1);
+  }
+  LoadIV(iv);
+  errors += CheckDispatch(key,message,versat_cypher,software_cypher);
+  CryptoDispatchSetThresholds(calibrated);
 
-    unsigned char seed[49];
-    HexStringToHex(seed,ptr);
+  printf("\n\n=======================================================\n");
+  printf("Dispatch tests: %s\n\n",(errors == 0) ? "OK" : "Error");
+  printf("  Calibration took: %d\n",end - start);
+  if(calibrated.shaBytes == SIZE_MAX){
+    printf("  SHA always uses software\n");
+  } else {
+    printf("  SHA uses Versat from %d bytes\n",(int) calibrated.shaBytes);
+  }
+  if(calibrated.aesBlocks == SIZE_MAX){
+    printf("  AES always uses software\n");
+  } else {
+    printf("  AES uses Versat from %d blocks\n",(int) calibrated.aesBlocks);
+  }
+  printf("  SHA job still running during the software hash: %s\n",busy ? "yes" : "no");
+  printf("=======================================================\n\n");
+
+  PopArena(globalArena,mark);
+  return (errors == 0) ? 0 : 1;
+}
+
+int VersatSHAAESBenchmark(int iterations){
+  if(iterations <= 0){
+    return 0;
+  }
+
+  static const int WARMUP = 2;
+  static const int SHA_SIZES[] = {0,64,256,1024,4096};
+  static const int AES_BLOCKS[] = {1,4,16,64};
+  static const int MAX_SIZE = 4096;
+
+  int mark = MarkArena(globalArena);
+
+  SHAAESBenchmarkData data;
+  SHAAESBenchmarkInit(&data,MAX_SIZE);
+
+  InitVersatSHA();
+
+  printf("\n\n=======================================================\n");
+  printf("SHA and AES benchmark: %d iterations after %d of warm-up\n",iterations,WARMUP);
+  printf("  Cycles per iteration (not seconds)\n");
+  BenchmarkPrintHeader();
+
+  for(int i = 0; i < (int) (sizeof(SHA_SIZES) / sizeof(SHA_SIZES[0])); i++){
+    int benchMark = MarkArena(globalArena);
+    data.size = SHA_SIZES[i];
+
+    Benchmark versat = BenchmarkCreate("SHA Versat",data.size,iterations);
+    Benchmark software = BenchmarkCreate("SHA software",data.size,iterations);
+    BenchmarkRun(&versat,BenchmarkVersatSHA,&data,WARMUP,iterations);
+    BenchmarkRun(&software,BenchmarkSoftwareSHA,&data,WARMUP,iterations);
+
+    printf("  %d bytes\n",data.size);
+    BenchmarkReport(&versat);
+    BenchmarkReport(&software);
+    PopArena(globalArena,benchMark);
+  }
+
+  for(int i = 0; i < (int) (sizeof(AES_BLOCKS) / sizeof(AES_BLOCKS[0])); i++){
+    int benchMark = MarkArena(globalArena);
+    data.size = AES_BLOCKS[i] * AES_BLK_SIZE;
+
+    Benchmark versat = BenchmarkCreate("AES Versat",data.size,iterations);
+    Benchmark software = BenchmarkCreate("AES software",data.size,iterations);
+    BenchmarkRun(&versat,BenchmarkVersatAES,&data,WARMUP,iterations);
+    BenchmarkRun(&software,BenchmarkSoftwareAES,&data,WARMUP,iterations);
+
+    printf("  %d blocks\n",AES_BLOCKS[i]);
+    BenchmarkReport(&versat);
+    BenchmarkReport(&software);
+    PopArena(globalArena,benchMark);
+  }
+
+  printf("=======================================================\n\n");
+  PopArena(globalArena,mark);
+
+  return 0;
+}
+
+// Only the first failures are kept, since they can only be printed after the whole KAT file is received
+#define MCELIECE_REPORTED_FAILURES 8
+
+// A test of the KAT, kept between the two transfers of the file
+typedef struct{
+  unsigned char seed[48];
+  uint8_t publicDigest[SHA_DIGEST_SIZE];
+  uint8_t secretDigest[SHA_DIGEST_SIZE];
+  int time;
+} McElieceKatTest;
+
+typedef struct{
+  int test;
+  bool publicMismatch;
+  bool secretMismatch;
+} McElieceFailure;
+
+int VersatMcElieceTests(){
+#if MCELIECE_PARAMETER_SET != MCELIECE348864
+  // The KAT file only covers mceliece348864
+  return McElieceRoundTripTests(PQCLEAN_MCELIECE_CLEAN_CRYPTO_ALGNAME,VersatMcEliece);
+#else
+  int mark = MarkArena(globalArena);
+
+  unsigned char* public_key = PushAlignedArray(globalArena,VERSAT_MCELIECE_PK_BUFFER_SIZE,unsigned char,VERSAT_MCELIECE_PK_BUFFER_ALIGN);
+  unsigned char* secret_key = PushArray(globalArena,PQCLEAN_MCELIECE_CLEAN_CRYPTO_SECRETKEYBYTES,unsigned char);
+
+  int versatTimeAccum = 0;
 
-    ptr = SearchAndAdvance(ptr,STRING("PK = "));
-    if(ptr == NULL){
-      printf("McEliece early exit 2. Something wrong with testfile\n");
+  // Printing while the file is being received would mix with the transfer, so the failures are reported after it
+  McElieceFailure failures[MCELIECE_REPORTED_FAILURES];
+  const char* earlyExit = NULL;
+
+  // The host sends the file without flow control and the UART only holds a few bytes, so a key generation cannot run while the file is
+  // being received. The seeds are read by a first transfer, the keys are generated with the UART idle and only their digests are kept,
+  // and a second transfer compares them with the digests of the keys in the file.
+  KatReader* reader = PushArray(globalArena,1,KatReader);
+  McElieceKatTest* katTests = PushArray(globalArena,0,McElieceKatTest);
+  KatReaderOpen(reader,"../../software/KAT/McElieceRound4kat_kem.rsp");
+
+  int tests = 0;
+  while(1){
+    if(!KatReaderSearch(reader,STRING("COUNT = "))){
       break;
     }
-  
-    char* good_pk = ptr;
 
-    ptr = SearchAndAdvance(ptr,STRING("PKL = "));
-    if(ptr == NULL){
-      printf("McEliece early exit 3. Something wrong with testfile\n");
+    if(!KatReaderSearch(reader,STRING("SEED = "))){
+      earlyExit = "McEliece early exit 1. Something wrong with testfile";
       break;
     }
 
-    char* good_pkl = ptr;
-
-    ptr = SearchAndAdvance(ptr,STRING("SK = "));
-    if(ptr == NULL){
-      printf("McEliece early exit 4. Something wrong with testfile\n");
+    // Tests are pushed one after the other, after the array start
+    McElieceKatTest* test = PushArray(globalArena,1,McElieceKatTest);
+    if(KatReaderHex(reader,(char*) test->seed,sizeof(test->seed)) != sizeof(test->seed)){
+      earlyExit = "McEliece early exit 2. Something wrong with testfile";
       break;
     }
 
-    char* good_sk = ptr;
+    tests += 1;
+  }
 
-    ptr = SearchAndAdvance(ptr,STRING("SKL = "));
-    if(ptr == NULL){
-      printf("McEliece early exit 5. Something wrong with testfile\n");
-      break;
-    }
+  KatReaderClose(reader);
 
-    char* good_skl = ptr;
+  for(int i = 0; i < tests && !earlyExit; i++){
+    McElieceKatTest* test = &katTests[i];
 
-    nist_kat_init(seed, NULL, 256);
+    nist_kat_init(test->seed, NULL, 256);
 
     int start = GetTime();
     VersatMcEliece(public_key, secret_key);
     int end = GetTime();
 
-    unsigned char* public_key_hex = PushArray(globalArena,PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_PUBLICKEYBYTES * 2 + 1,unsigned char);
-    unsigned char* secret_key_hex = PushArray(globalArena,PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_SECRETKEYBYTES * 2 + 1,unsigned char);
+    test->time = end - start;
 
-    GetHexadecimal(public_key,public_key_hex,PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_PUBLICKEYBYTES);
-    GetHexadecimal(secret_key,secret_key_hex,PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_SECRETKEYBYTES);
+    sha256(test->publicDigest,public_key,PQCLEAN_MCELIECE_CLEAN_CRYPTO_PUBLICKEYBYTES);
+    sha256(test->secretDigest,secret_key,PQCLEAN_MCELIECE_CLEAN_CRYPTO_SECRETKEYBYTES);
+  }
 
-    bool good = true;
-    for(int i = 0; i < 1024; i++){
-      if(public_key_hex[i] != good_pk[i]){
-        good = false;
-        break;
-      }
-      if(public_key_hex[i + PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_PUBLICKEYBYTES * 2 - 1024] != good_pkl[i]){
-        good = false;
+  int goodTests = 0;
+  int checked = 0;
+  if(!earlyExit){
+    KatReaderOpen(reader,"../../software/KAT/McElieceRound4kat_kem.rsp");
+
+    for(; checked < tests; checked++){
+      McElieceKatTest* test = &katTests[checked];
+      uint8_t digest[SHA_DIGEST_SIZE];
+
+      if(!KatReaderSearch(reader,STRING("PK = "))){
+        earlyExit = "McEliece early exit 3. Something wrong with testfile";
         break;
       }
-    }
-    for(int i = 0; i < 1024; i++){
-      if(secret_key_hex[i] != good_sk[i]){
-        good = false;
+
+      bool publicMismatch = !KatReaderDigest(reader,digest,PQCLEAN_MCELIECE_CLEAN_CRYPTO_PUBLICKEYBYTES);
+      publicMismatch |= (memcmp(digest,test->publicDigest,SHA_DIGEST_SIZE) != 0);
+
+      if(!KatReaderSearch(reader,STRING("SK = "))){
+        earlyExit = "McEliece early exit 4. Something wrong with testfile";
         break;
       }
-      if(secret_key_hex[i + PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_SECRETKEYBYTES * 2 - 1024] != good_skl[i]){
-        good = false;
-        break;
+
+      bool secretMismatch = !KatReaderDigest(reader,digest,PQCLEAN_MCELIECE_CLEAN_CRYPTO_SECRETKEYBYTES);
+      secretMismatch |= (memcmp(digest,test->secretDigest,SHA_DIGEST_SIZE) != 0);
+
+      if(!publicMismatch && !secretMismatch){
+        versatTimeAccum += test->time;
+        goodTests += 1;
+      } else if(checked - goodTests < MCELIECE_REPORTED_FAILURES){
+        failures[checked - goodTests] = (McElieceFailure){checked,publicMismatch,secretMismatch};
       }
     }
 
-    if(good){
-      versatTimeAccum += end - start;
-      goodTests += 1;
-    } else {
-      printf("McEliece Test %02d: Error\n",tests);
-      printf("  Expected Public      (first 32 chars): %.32s\n",good_pk); 
-      printf("  Expected Public Last (first 32 chars): %.32s\n",good_pkl); 
-      printf("  Expected Secret      (first 32 chars): %.32s\n",good_sk);  
-      printf("  Expected Secret Last (first 32 chars): %.32s\n",good_skl); 
-      printf("  Got Public      (first 32 chars):      %.32s\n",public_key_hex);
-      printf("  Got Public Last (first 32 chars):      %.32s\n",&public_key_hex[PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_PUBLICKEYBYTES * 2 - 1024]);
-      printf("  Got Secret      (first 32 chars):      %.32s\n",secret_key_hex);
-      printf("  Got Secret Last (first 32 chars):      %.32s\n",&secret_key_hex[PQCLEAN_MCELIECE348864_CLEAN_CRYPTO_SECRETKEYBYTES * 2 - 1024]);
-    }
+    KatReaderClose(reader);
+  }
 
-    tests += 1;
-    PopArena(globalArena,testMark);
-    break;
+  if(earlyExit){
+    printf("%s\n",earlyExit);
+  }
+
+  int failed = checked - goodTests;
+  for(int i = 0; i < failed && i < MCELIECE_REPORTED_FAILURES; i++){
+    McElieceFailure failure = failures[i];
+    printf("McEliece Test %02d: Error\n",failure.test);
+    if(failure.publicMismatch){
+      printf("  Public key differs from the KAT\n");
+    }
+    if(failure.secretMismatch){
+      printf("  Secret key differs from the KAT\n");
+    }
+  }
+  if(failed > MCELIECE_REPORTED_FAILURES){
+    printf("  ... and %d other failed tests\n",failed - MCELIECE_REPORTED_FAILURES);
   }
+
   printf("\n\n=======================================================\n");
   printf("McEliece tests: %d passed out of %d\n",goodTests,tests);
-  printf("  No time taken since software implementation is really\n");
+  printf("  Versat key generation: %d\n",versatTimeAccum);
+  printf("  Software implementation is not timed since it is really\n");
   printf("  slow, so we would just be wasting time. We are already\n");
-  printf("  comparing solutions to a KAT.\n");
+  printf("  comparing solutions to a KAT. Build with\n");
+  printf("  MCELIECE_BENCHMARK=<keygens> to compare both.\n");
   printf("=======================================================\n\n");
   PopArena(globalArena,mark);
 
-  return (goodTests == tests) ? 0 : 1;
+  return (goodTests == tests && !earlyExit) ? 0 : 1;
+#endif
+}
+
+#ifdef MCELIECE_BENCHMARK
+/**
+ * \brief Prints the average of a time accumulated over every key generation of the benchmark
+ */
+static void PrintAverageTime(const char* name,int64_t accum,int keygens){
+  printf("%s: %d\n",name,(int) (accum / keygens));
+}
+
+int VersatMcElieceBenchmark(int keygens){
+  if(keygens <= 0){
+    return 0;
+  }
+
+  int mark = MarkArena(globalArena);
+
+  unsigned char* public_key = PushAlignedArray(globalArena,VERSAT_MCELIECE_PK_BUFFER_SIZE,unsigned char,VERSAT_MCELIECE_PK_BUFFER_ALIGN);
+  unsigned char* secret_key = PushArray(globalArena,PQCLEAN_MCELIECE_CLEAN_CRYPTO_SECRETKEYBYTES,unsigned char);
+  unsigned char* software_public_key = PushArray(globalArena,PQCLEAN_MCELIECE_CLEAN_CRYPTO_PUBLICKEYBYTES,unsigned char);
+  unsigned char* software_secret_key = PushArray(globalArena,PQCLEAN_MCELIECE_CLEAN_CRYPTO_SECRETKEYBYTES,unsigned char);
+
+  // A single software key generation can take longer than an int can count, so times are accumulated in 64 bits
+  int64_t versatTimeAccum = 0;
+  int64_t seedTimeAccum = 0;
+  int64_t genpolyTimeAccum = 0;
+  int64_t sortTimeAccum = 0;
+  int64_t checkTimeAccum = 0;
+  int64_t fillTimeAccum = 0;
+  int64_t eliminationTimeAccum = 0;
+  int64_t controlBitsTimeAccum = 0;
+  int64_t softwareTimeAccum = 0;
+  int retries = 0;
+  int maxAttempts = 0;
+  int goodKeys = 0;
+
+  Benchmark versatSamples = BenchmarkCreate("Versat key generation",0,keygens);
+  Benchmark softwareSamples = BenchmarkCreate("Software key generation",0,keygens);
+
+  for(int i = 0; i < keygens; i++){
+    // Both implementations start from the same seed, so they go through the same attempts and produce the same keys
+    unsigned char seed[48];
+    for(int j = 0; j < 48; j++){
+      seed[j] = i + j;
+    }
+
+    nist_kat_init(seed, NULL, 256);
+
+    int start = GetTime();
+    VersatMcEliece(public_key, secret_key);
+    int end = GetTime();
+
+    McElieceProfile profile = GetMcElieceProfile();
+    versatTimeAccum += (uint32_t) (end - start);
+    BenchmarkRecord(&versatSamples,(uint32_t) (end - start));
+    seedTimeAccum += profile.seedExpansion;
+    genpolyTimeAccum += profile.genpoly;
+    sortTimeAccum += profile.sort;
+    checkTimeAccum += profile.systematicCheck;
+    fillTimeAccum += profile.matrixFill;
+    eliminationTimeAccum += profile.elimination;
+    controlBitsTimeAccum += profile.controlBits;
+    retries += profile.attempts - 1;
+    if(profile.attempts > maxAttempts){
+      maxAttempts = profile.attempts;
+    }
+
+    nist_kat_init(seed, NULL, 256);
+
+    start = GetTime();
+    PQCLEAN_MCELIECE_CLEAN_crypto_kem_keypair(software_public_key, software_secret_key);
+    end = GetTime();
+
+    softwareTimeAccum += (uint32_t) (end - start);
+    BenchmarkRecord(&softwareSamples,(uint32_t) (end - start));
+
+    if(memcmp(public_key,software_public_key,PQCLEAN_MCELIECE_CLEAN_CRYPTO_PUBLICKEYBYTES) == 0 &&
+       memcmp(secret_key,software_secret_key,PQCLEAN_MCELIECE_CLEAN_CRYPTO_SECRETKEYBYTES) == 0){
+      goodKeys += 1;
+    } else {
+      printf("McEliece Benchmark %02d: Error\n",i);
+      printf("  Versat keys do not match the software keys\n");
+    }
+  }
+
+  int64_t phasesAccum = seedTimeAccum + genpolyTimeAccum + sortTimeAccum + checkTimeAccum +
+                        fillTimeAccum + eliminationTimeAccum + controlBitsTimeAccum;
+
+  printf("\n\n=======================================================\n");
+  printf("McEliece key generation benchmark: %d keygens\n",keygens);
+  printf("Average time of a key generation:\n");
+  PrintAverageTime("  Versat key generation",versatTimeAccum,keygens);
+  PrintAverageTime("    Seed expansion",seedTimeAccum,keygens);
+  PrintAverageTime("    Irreducible polynomial",genpolyTimeAccum,keygens);
+  PrintAverageTime("    Sort",sortTimeAccum,keygens);
+  PrintAverageTime("    Systematic check",checkTimeAccum,keygens);
+  PrintAverageTime("    Matrix fill",fillTimeAccum,keygens);
+  PrintAverageTime("    Elimination",eliminationTimeAccum,keygens);
+  PrintAverageTime("    Control bits",controlBitsTimeAccum,keygens);
+  PrintAverageTime("    Other",versatTimeAccum - phasesAccum,keygens);
+  PrintAverageTime("  Software key generation (pk_gen.c)",softwareTimeAccum,keygens);
+  printf("  Retries: %d in total, at most %d attempts for a key\n",retries,maxAttempts);
+  printf("  Keys equal to the software keys: %d out of %d\n",goodKeys,keygens);
+  printf("Distribution of the time of a key generation:\n");
+  BenchmarkPrintHeader();
+  BenchmarkReport(&versatSamples);
+  BenchmarkReport(&softwareSamples);
+  printf("=======================================================\n\n");
+  PopArena(globalArena,mark);
+
+  return (goodKeys == keygens) ? 0 : 1;
+}
+#endif
+
+int VersatRootTests(){
+  int mark = MarkArena(globalArena);
+
+  uint16_t* f = PushAlignedArray(globalArena,SYS_T + 1,uint16_t,4);
+  uint16_t* L = PushAlignedArray(globalArena,SYS_N,uint16_t,4);
+  uint16_t* versat_values = PushAlignedArray(globalArena,SYS_N,uint16_t,4);
+
+  // Every coefficient is nonzero, so a coefficient that does not reach the unit changes the values
+  for(int i = 0; i < SYS_T; i++){
+    f[i] = (uint16_t) (((i * 97 + 13) & GFMASK) | 1);
+  }
+  f[SYS_T] = 1;
+
+  for(int i = 0; i < SYS_N; i++){
+    L[i] = (uint16_t) ((i * 1237 + 5) & GFMASK);
+  }
+
+  VersatRoot(versat_values,f,L);
+
+  int errors = 0;
+  int firstError = -1;
+  for(int i = 0; i < SYS_N; i++){
+    if(versat_values[i] != eval(f,L[i])){
+      if(firstError < 0){
+        firstError = i;
+      }
+      errors += 1;
+    }
+  }
+
+  printf("\n\n=======================================================\n");
+  printf("Root tests: %s\n",(errors == 0) ? "OK" : "Error");
+  if(errors){
+    printf("  %d of %d values differ from software, the first at index %d\n",errors,SYS_N,firstError);
+  }
+  printf("=======================================================\n\n");
+
+  PopArena(globalArena,mark);
+  return (errors == 0) ? 0 : 1;
+}
+
+int VersatMcElieceSemiSystematicTests(){
+  // There is no KAT for the semi-systematic variant
+  return McElieceRoundTripTests("McEliece semi-systematic",VersatMcElieceSemiSystematic);
 }
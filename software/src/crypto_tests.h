@@ -38,9 +38,6 @@ typedef struct {
   int earlyExit; 
 } TestState;
 
-//! IOBb-SoC firmware must implement this function so that testcases can record time taken
-int GetTime(); 
-
 /** 
  * Testcases follow a structures where values are in the form "VAL = ...". This function can search for VAL and return a pointer to the first character after the string
  * \brief Simple function to parse content file and find specific values.
@@ -94,6 +91,29 @@ int VersatSHATests();
  */
 int VersatAESTests();
 
+/** 
+ * Hashes a message and encrypts blocks with AES, first one after the other and then with both jobs sharing the accelerator runs, and checks the results against software.
+ * \brief Runs the Versat test of SHA and AES sharing the accelerator.
+ * \return 0 if successful, any other number if error
+ */
+int VersatMixedSHAAESTests();
+
+/**
+ * Calibrates the thresholds of crypto_sha256 and crypto_aes256_ecb_encrypt and prints them.
+ * Then compares both functions with the software implementations with the accelerator always used, never used and used from the calibrated thresholds,
+ * while a SHA job is queued and after an IV is loaded for CBC. The calibrated thresholds stay in use afterwards.
+ * \brief Runs the tests of the hardware/software dispatch.
+ * \return 0 if every result matches the software implementation, any other number otherwise
+ */
+int VersatDispatchTests();
+
+/**
+ * Evaluates a polynomial with every coefficient nonzero at the support with VersatRoot and compares the values with eval from root.c.
+ * \brief Runs the tests of the Versat polynomial evaluation used by McEliece.
+ * \return 0 if successful, any other number if error
+ */
+int VersatRootTests();
+
 /** 
  * Implements the McEliece tests. This function obtains KAT data from outside.
  * \brief Implements and runs the Versat McEliece tests for embedded.
@@ -101,10 +121,38 @@ int VersatAESTests();
  */
 int VersatMcElieceTests();
 
+/** 
+ * Generates keys with the semi-systematic variant and checks them by encapsulating and decapsulating a shared secret.
+ * \brief Runs the Versat semi-systematic McEliece tests for embedded.
+ * \return 0 if successful, any other number if error
+ */
+int VersatMcElieceSemiSystematicTests();
+
+#ifdef MCELIECE_BENCHMARK
+/** 
+ * Every key is generated twice from the same seed, by VersatMcEliece and by the software only crypto_kem_keypair that uses pk_gen.c, and the keys are compared.
+ * Prints the average time of each phase of VersatMcEliece, the number of retries and the average time of the software implementation,
+ * followed by the distribution of the time of a key generation of both.
+ * \brief Benchmarks Versat McEliece key generation against the software implementation.
+ * \param keygens number of keys to generate
+ * \return 0 if every Versat key matches the software key, any other number otherwise
+ */
+int VersatMcElieceBenchmark(int keygens);
+#endif
+
+/**
+ * Times VersatSHA against sha256 for messages of 0 to 4096 bytes, and VersatAES256ECBSubmit against tiny-AES for 1 to 64 blocks.
+ * Prints the minimum, median, 90th and 99th percentile and maximum time of each size, and the throughput at the median.
+ * \brief Benchmarks Versat SHA and AES against the software implementations.
+ * \param iterations number of timed iterations of each size, after a short warm-up
+ * \return 0
+ */
+int VersatSHAAESBenchmark(int iterations);
+
 /** 
  * Parses content and runs testcases with the given values and compares to the expected result
  * \brief Fuction that implements the SHA tests.
- * \param content a String with the content of the KAT
+ * \param content a String with the content of the KAT. Needs to be writable, the expected results are decoded in place
  * \return the result of running all the tests
  */
 TestState VersatCommonSHATests(String content);
@@ -112,7 +160,16 @@ TestState VersatCommonSHATests(String content);
 /** 
  * Parses content and runs testcases with the given values and compares to the expected result
  * \brief Fuction that implements the AES tests.
- * \param content a String with the content of the KAT
+ * \param content a String with the content of the KAT. Needs to be writable, the expected results are decoded in place
  * \return the result of running all the tests
  */
 TestState VersatCommonAESTests(String content);
+
+/**
+ * Times VersatSHA against sha256 for messages of 0 and 1 byte to 64 KiB in powers of two, and the FullAES unit against tiny-AES for 1 to 4096 blocks.
+ * Prints a CSV table with the minimum and median time of both implementations at each size, followed by the size from which Versat is faster.
+ * \brief Sweeps the message length of SHA and AES to find where Versat starts to be faster than software.
+ * \param iterations number of timed iterations of each size
+ * \return 0 if the Versat results match the software ones at every size, any other number otherwise
+ */
+int VersatCommonSweepBenchmark(int iterations);
@@ -11,6 +11,10 @@
 
 #include "arena.h"
 #include "crypto_tests.h"
+#include "versat_crypto.h"
+
+// McEliece
+#include "api.h"
 
 int GetTime(){
   return (int) timer_get_count();
@@ -19,6 +23,18 @@ int GetTime(){
 #define Kilo(VAL) (1024 * (VAL))
 #define Mega(VAL) (1024 * Kilo(VAL))
 
+// The McEliece tests use most of the arena: the key generation buffer and the secret key, and the working memory of key generation,
+// which grows with the size of the field. The benchmark also holds the keys of the software implementation while it builds its matrix.
+// The rest covers the SHA and AES KAT files and the KAT reader. The high water mark printed after the tests is the amount of memory that was actually needed.
+#define MCELIECE_KEYS_SIZE (VERSAT_MCELIECE_PK_BUFFER_SIZE + PQCLEAN_MCELIECE_CLEAN_CRYPTO_SECRETKEYBYTES)
+#define MCELIECE_WORKING_SIZE ((1 << GFBITS) * 32)
+#ifdef MCELIECE_BENCHMARK
+#define MCELIECE_SOFTWARE_SIZE (PK_NROWS * PK_ROW_BYTES + PQCLEAN_MCELIECE_CLEAN_CRYPTO_SECRETKEYBYTES + PK_NROWS * (SYS_N / 8))
+#else
+#define MCELIECE_SOFTWARE_SIZE 0
+#endif
+#define ARENA_SIZE (MCELIECE_KEYS_SIZE + MCELIECE_WORKING_SIZE + MCELIECE_SOFTWARE_SIZE + Kilo(64))
+
 /**
  * Initializes the peripherals and calls the functions that exercise the algorithms testcases.
  * McEliece tests are disabled in simulation since they would take a huge amount of time running. It would be faster to compile and run on a FPGA.
@@ -39,7 +55,7 @@ int main() {
 
   // Allocates an arena, basically a stack allocator where we can push and pop memory on command.
   Arena globalArenaInst = {};
-  globalArenaInst.allocated = Mega(1); // We need at least half a megabyte for McEliece
+  globalArenaInst.allocated = ARENA_SIZE;
   globalArenaInst.ptr = malloc(globalArenaInst.allocated);
   globalArena = &globalArenaInst;
 
@@ -55,13 +71,28 @@ int main() {
   uart_puts("\n\n\nPC tests\n\n\n");
   test_result |= VersatSHATests();
   test_result |= VersatAESTests();
+  test_result |= VersatMixedSHAAESTests();
+  test_result |= VersatDispatchTests();
+  test_result |= VersatRootTests();
   test_result |= VersatMcElieceTests();
+  test_result |= VersatMcElieceSemiSystematicTests();
+#ifdef MCELIECE_BENCHMARK
+  test_result |= VersatMcElieceBenchmark(MCELIECE_BENCHMARK);
+#endif
+#ifdef CRYPTO_BENCHMARK
+  test_result |= VersatSHAAESBenchmark(CRYPTO_BENCHMARK);
+#endif
+#ifdef SWEEP_BENCHMARK
+  test_result |= VersatCommonSweepBenchmark(SWEEP_BENCHMARK);
+#endif
 #else
   uart_puts("\n\n\nSim tests\n\n\n");
   test_result |= VersatSHASimulationTests();
   test_result |= VersatAESSimulationTests();
 #endif
 
+  printf("Arena high water mark: %d of %d bytes\n",globalArena->highWater,globalArena->allocated);
+
   if(test_result){
     uart_sendfile("test.log", strlen(fail_string), fail_string);
   } else {
@@ -1,6 +1,8 @@
 #include "versat_crypto.h"
 
 #include "versat_accel.h"
+#include "versat_shadow.h"
+#include "versat_sequence.h"
 
 #include <string.h>
 
@@ -16,6 +18,32 @@
 
 static CryptoAlgosAddr aesAddr;
 
+// Key currently expanded inside the key regfile, so that it is only expanded again when it changes
+static uint8_t expandedKey[AES_KEY_SIZE];
+static bool expandedKeyValid = false;
+
+// Set while the datapath is configured for encryption and lastResult and lastValToAdd are zero
+static bool encryptionReady = false;
+
+// Configuration sequences of the key expansion and of a block, indexed by is256. Built by InitVersatAES
+#define EXPAND_DELTAS 8
+static ConfigStep expandSteps128[10];
+static ConfigStep expandSteps256[13];
+static ConfigDelta expandDeltas128[10 * EXPAND_DELTAS];
+static ConfigDelta expandDeltas256[13 * EXPAND_DELTAS];
+static ConfigStep encryptSteps128[11];
+static ConfigStep encryptSteps256[15];
+static ConfigDelta encryptDeltas128[11];
+static ConfigDelta encryptDeltas256[15];
+static ConfigStep decryptSteps128[11];
+static ConfigStep decryptSteps256[15];
+static ConfigDelta decryptDeltas128[11];
+static ConfigDelta decryptDeltas256[15];
+
+static ConfigSequence expandSequence[2];
+static ConfigSequence encryptSequence[2];
+static ConfigSequence decryptSequence[2];
+
 //! SBox lookup table. Values are defined by the AES algorithm
 const uint8_t sbox[256] = {
    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
@@ -178,6 +206,9 @@ const uint8_t mul14[] = {
    0xd7,0xd9,0xcb,0xc5,0xef,0xe1,0xf3,0xfd,0xa7,0xa9,0xbb,0xb5,0x9f,0x91,0x83,0x8d
 };
 
+//! Round constants used by the key expansion. Values are defined by the AES algorithm
+static const int rcon[] = {0x01,0x02,0x04,0x08,0x10,0x20,0x40,0x80,0x1b,0x36};
+
 /**
  * \brief Fills a lookup table unit contents from memory
  * \param addr of lookup table unit to fill
@@ -267,10 +298,10 @@ void FillInvMainRound(FullAESRoundsAddr addr){
  * \param is256 wether we want AES-128 or AES-256
  */
 void ExpandKey(uint8_t* key,bool is256){
-  static  const int rcon[] = {0x01,0x02,0x04,0x08,0x10,0x20,0x40,0x80,0x1b,0x36};
-
   CryptoAlgosConfig* config = (CryptoAlgosConfig*) accelConfig;
 
+  expandedKeyValid = false;
+
   // Start by storing in position 0 the initial key
   RegFileAddr* view = &aesAddr.aes.key_0;
   for(int i = 0; i < 16; i++){
@@ -284,57 +315,16 @@ void ExpandKey(uint8_t* key,bool is256){
     }   
   }
 
-  config->aes.key_0.disabled = 0;
+  ShadowWrite(&config->aes.key_0.disabled,0);
 
-  if(is256){
-    for(int i = 0; i < 13; i++){
-      // Constant defined by AES
-      if(i % 2 == 1) {
-        config->aes.rcon.constant = 0;
-      } else {
-        config->aes.rcon.constant = rcon[i / 2];
-      }
-
-      // Selects keys in position i and i+1 to calculate position i+2
-      config->aes.key_0.selectedOutput0 = i;
-      config->aes.key_0.selectedOutput1 = i + 1;
-      config->aes.key_0.selectedInput = i + 2;
-
-      // This changes which rows are processed.
-      // Needed by 256 because they differ between rounds
-      // Check the GenericLineKey unit inside the versatSpec.txt file
-      config->aes.schedule.s.mux_0.sel = (i + 1) % 2;
-      config->aes.schedule.s.mux_1.sel = (i + 1) % 2;
-      config->aes.schedule.s.mux_2.sel = (i + 1) % 2;
-      config->aes.schedule.s.mux_3.sel = (i + 1) % 2;
-
-      EndAccelerator();
-      StartAccelerator();
-    }
-  } else {
-    // AES 128 does not need to change processing type
-    // It always the same
-    config->aes.schedule.s.mux_0.sel = 1;
-    config->aes.schedule.s.mux_1.sel = 1;
-    config->aes.schedule.s.mux_2.sel = 1;
-    config->aes.schedule.s.mux_3.sel = 1;
-    for(int i = 0; i < 10; i++){
-      config->aes.rcon.constant = rcon[i];
-
-      // AES 128 uses key in position i to produce key in position i+1
-      config->aes.key_0.selectedOutput0 = i;
-      config->aes.key_0.selectedOutput1 = i;
-      config->aes.key_0.selectedInput = i + 1;
-
-      EndAccelerator();
-      StartAccelerator();
-    } 
-  }
+  // AES 256 uses keys in positions i and i+1 to calculate position i+2, AES 128 uses key in position i to produce key in position i+1
+  const ConfigSequence* seq = &expandSequence[is256];
+  SequenceRunSteps(seq,0,seq->numberSteps);
 
   EndAccelerator();
 
   // After calculating the key, disable regfile so that following runs do not change the content of the key regfile.
-  config->aes.key_0.disabled = 1;
+  ShadowWrite(&config->aes.key_0.disabled,1);
 }
 
 /**
@@ -363,31 +353,15 @@ void Encrypt(uint8_t* data,uint8_t* result,uint8_t* lastAddition,bool is256,bool
     VersatUnitWrite(view[i].addr,0,data[i]);
   }
 
-  // Activate the pre-round datapath
-  ActivateMergedAccelerator(MergeType_AESFirstAdd);
-
-  // Select key block 0, since it is used by the preround to perform the first addition
-  config->aes.key_0.selectedOutput0 = 0;
-
-  StartAccelerator(); // Process the pre-round step
-
-  // Active the round datapath
-  ActivateMergedAccelerator(MergeType_AESRound);
-
-  // Process the rounds (10-1 for 128 bits and 14-1 for 256 bits). Last round has special processing
-  for(int i = 0; i < (numberRounds-1); i++){
-    config->aes.key_0.selectedOutput0 = i + 1; // Change key blocks as they are required by the rounds.
-    EndAccelerator();
-    StartAccelerator();
-  }
-
-  // Activate last round datapath
-  ActivateMergedAccelerator(MergeType_AESLastRound);
-  config->aes.key_0.selectedOutput0 = numberRounds; // Select last key block
+  // Pre-round and rounds (10-1 for 128 bits and 14-1 for 256 bits), then the configuration of the last round, which has special processing
+  const ConfigSequence* seq = &encryptSequence[is256];
+  SequenceRunSteps(seq,0,numberRounds);
+  SequenceApplyStep(seq,numberRounds);
 
   // For CBC mode, store the last result
   if(isCBC){
-    config->aes.lastResult_0.disabled = 0;
+    ShadowWrite(&config->aes.lastResult_0.disabled,0);
+    encryptionReady = false; // lastResult is no longer zero
   }
 
   EndAccelerator();
@@ -398,11 +372,12 @@ void Encrypt(uint8_t* data,uint8_t* result,uint8_t* lastAddition,bool is256,bool
     for(int i = 0; i < 16; i++){
       VersatUnitWrite(view[i].addr,0,lastAddition[i]);
     }    
+    encryptionReady = false; // lastValToAdd is no longer zero
   }
 
   StartAccelerator();
 
-  config->aes.lastResult_0.disabled = 1; // Disable lastResult so that following runs do not change contents
+  ShadowWrite(&config->aes.lastResult_0.disabled,1); // Disable lastResult so that following runs do not change contents
 
   EndAccelerator();
 
@@ -427,40 +402,82 @@ void Decrypt(uint8_t* data,uint8_t* result,bool is256){
     numberRounds = 14;
   }
 
-  CryptoAlgosConfig* config = (CryptoAlgosConfig*) accelConfig;
-
   RegAddr* view = &aesAddr.aes.state_0;
   for(int i = 0; i < 16; i++){
     VersatUnitWrite(view[i].addr,0,data[i]);
   }
 
   // Same deal as encryption, except the decrypt units have Inv in their name
-  ActivateMergedAccelerator(MergeType_AESInvFirstAdd);
-  config->aes.key_0.selectedOutput0 = numberRounds;
+  const ConfigSequence* seq = &decryptSequence[is256];
+  SequenceRunSteps(seq,0,numberRounds + 1);
 
-  StartAccelerator();
+  EndAccelerator();
 
-  ActivateMergedAccelerator(MergeType_AESInvRound);
-   
-  // Key blocks selected starting from number rounds until 0.
-  for(int i = (numberRounds - 1); i > 0; i--){
-    config->aes.key_0.selectedOutput0 = i;
-    EndAccelerator();
-    StartAccelerator();
+  for(int ii = 0; ii < 16; ii++){
+    result[ii] = VersatUnitRead(view[ii].addr,0);
   }
+}
 
-  ActivateMergedAccelerator(MergeType_AESInvLastRound);
-  config->aes.key_0.selectedOutput0 = 0;
+/**
+ * The key expansion computes one key block per run. The encryption and decryption of a block change the datapath
+ * from preRound -> Round -> lastRound and select the key block used by each round, forward for encryption and backwards for decryption.
+ * \brief Builds the configuration sequences of the key expansion, encryption and decryption
+ * \param is256 wether the sequences are for AES-128 or AES-256
+ */
+static void BuildAESSequences(bool is256){
+   CryptoAlgosConfig* config = (CryptoAlgosConfig*) accelConfig;
+   int numberRounds = is256 ? 14 : 10;
 
-  EndAccelerator();
+   ConfigSequence* seq = &expandSequence[is256];
+   if(is256){
+      SequenceInit(seq,expandSteps256,ARRAY_SIZE(expandSteps256),expandDeltas256,ARRAY_SIZE(expandDeltas256));
+   } else {
+      SequenceInit(seq,expandSteps128,ARRAY_SIZE(expandSteps128),expandDeltas128,ARRAY_SIZE(expandDeltas128));
+   }
 
-  StartAccelerator();
+   for(int i = 0; i < (is256 ? 13 : 10); i++){
+      SequenceStep(seq,-1);
 
-  EndAccelerator();
+      // AES 256 uses keys in positions i and i+1 to calculate position i+2 and changes which rows are processed between rounds.
+      // Check the GenericLineKey unit inside the versatSpec.txt file
+      int rc = is256 ? ((i % 2 == 1) ? 0 : rcon[i / 2]) : rcon[i];
+      int sel = is256 ? (i + 1) % 2 : 1;
+
+      SequenceSet(seq,&config->aes.rcon.constant,rc);
+      SequenceSet(seq,&config->aes.key_0.selectedOutput0,i);
+      SequenceSet(seq,&config->aes.key_0.selectedOutput1,is256 ? i + 1 : i);
+      SequenceSet(seq,&config->aes.key_0.selectedInput,is256 ? i + 2 : i + 1);
+      SequenceSet(seq,&config->aes.schedule.s.mux_0.sel,sel);
+      SequenceSet(seq,&config->aes.schedule.s.mux_1.sel,sel);
+      SequenceSet(seq,&config->aes.schedule.s.mux_2.sel,sel);
+      SequenceSet(seq,&config->aes.schedule.s.mux_3.sel,sel);
+   }
 
-  for(int ii = 0; ii < 16; ii++){
-    result[ii] = VersatUnitRead(view[ii].addr,0);
-  }
+   seq = &encryptSequence[is256];
+   if(is256){
+      SequenceInit(seq,encryptSteps256,ARRAY_SIZE(encryptSteps256),encryptDeltas256,ARRAY_SIZE(encryptDeltas256));
+   } else {
+      SequenceInit(seq,encryptSteps128,ARRAY_SIZE(encryptSteps128),encryptDeltas128,ARRAY_SIZE(encryptDeltas128));
+   }
+
+   for(int i = 0; i <= numberRounds; i++){
+      int merge = (i == 0) ? MergeType_AESFirstAdd : (i == 1) ? MergeType_AESRound : (i == numberRounds) ? MergeType_AESLastRound : -1;
+      SequenceStep(seq,merge);
+      SequenceSet(seq,&config->aes.key_0.selectedOutput0,i);
+   }
+
+   seq = &decryptSequence[is256];
+   if(is256){
+      SequenceInit(seq,decryptSteps256,ARRAY_SIZE(decryptSteps256),decryptDeltas256,ARRAY_SIZE(decryptDeltas256));
+   } else {
+      SequenceInit(seq,decryptSteps128,ARRAY_SIZE(decryptSteps128),decryptDeltas128,ARRAY_SIZE(decryptDeltas128));
+   }
+
+   for(int i = 0; i <= numberRounds; i++){
+      int merge = (i == 0) ? MergeType_AESInvFirstAdd : (i == 1) ? MergeType_AESInvRound : (i == numberRounds) ? MergeType_AESInvLastRound : -1;
+      SequenceStep(seq,merge);
+      SequenceSet(seq,&config->aes.key_0.selectedOutput0,numberRounds - i);
+   }
 }
 
 /**
@@ -470,6 +487,12 @@ void Decrypt(uint8_t* data,uint8_t* result,bool is256){
 void InitVersatAES(){
    aesAddr = (CryptoAlgosAddr) ACCELERATOR_TOP_ADDR_INIT;
    FillKeySchedule(aesAddr.aes.schedule);
+
+   BuildAESSequences(false);
+   BuildAESSequences(true);
+
+   expandedKeyValid = false;
+   encryptionReady = false;
 }
 
 /**
@@ -495,7 +518,9 @@ void InitAESEncryption(){
    }
 
    // Prevent lastResult from updating
-   config->aes.lastResult_0.disabled = 1;
+   ShadowWrite(&config->aes.lastResult_0.disabled,1);
+
+   encryptionReady = true;
 }
 
 /**
@@ -506,6 +531,8 @@ void InitAESDecryption(){
    CryptoAlgosConfig* config = (CryptoAlgosConfig*) accelConfig;
    FillInvMainRound(aesAddr.aes.round);
 
+   encryptionReady = false;
+
    // Clear out lastResult and lastValToAdd
    {
       RegAddr* view = &aesAddr.aes.lastResult_0;
@@ -521,7 +548,7 @@ void InitAESDecryption(){
    }
 
    // Prevent lastResult from updating
-   config->aes.lastResult_0.disabled = 1;
+   ShadowWrite(&config->aes.lastResult_0.disabled,1);
 }
 
 /**
@@ -536,9 +563,10 @@ void LoadIV(uint8_t* iv){
    for(int i = 0; i < 16; i++){
       VersatUnitWrite(view[i].addr,0,iv[i]);
    }
+   encryptionReady = false; // lastResult is no longer zero
 
    // Prevent lastResult from updating
-   config->aes.lastResult_0.disabled = 1;
+   ShadowWrite(&config->aes.lastResult_0.disabled,1);
 }
 
 typedef enum{
@@ -556,6 +584,120 @@ void AES_ECB256(uint8_t* key,uint8_t* plaintext,uint8_t* result){
    Encrypt(plaintext,result,NULL,true,false);
 }
 
+void VersatAES256CTRBlocks(const uint8_t* key,uint8_t* counter,uint8_t* out,size_t nblocks){
+   if(!encryptionReady){
+      InitVersatAES();
+      InitAESEncryption();
+   }
+
+   // Every block uses the same round keys, only expand them when the key changes
+   if(!expandedKeyValid || memcmp(expandedKey,key,AES_KEY_SIZE) != 0){
+      memcpy(expandedKey,key,AES_KEY_SIZE);
+      ExpandKey(expandedKey,true);
+      expandedKeyValid = true;
+   }
+
+   for(size_t i = 0; i < nblocks; i++){
+      // 128 bit big endian increment
+      for(int j = AES_BLK_SIZE - 1; j >= 0; j--){
+         counter[j] += 1;
+         if(counter[j] != 0){
+            break;
+         }
+      }
+
+      Encrypt(counter,out + i * AES_BLK_SIZE,NULL,true,false);
+   }
+}
+
+// Runs taken by the key expansion and by the encryption of a block with AES-256
+#define AES256_EXPANSION_RUNS 13
+#define AES256_BLOCK_RUNS 15
+
+// Same sequences of runs as ExpandKey followed by Encrypt for each block
+static void ConfigureAESRun(VersatJob* job,int run){
+   VersatAESJob* aes = (VersatAESJob*) job->context;
+   CryptoAlgosConfig* config = (CryptoAlgosConfig*) accelConfig;
+
+   if(aes->expand){
+      if(run == 0){
+         expandedKeyValid = false;
+
+         RegFileAddr* view = &aesAddr.aes.key_0;
+         for(int i = 0; i < 16; i++){
+            VersatUnitWrite(view[i].addr,0,aes->key[i]);
+            VersatUnitWrite(view[i].addr,1,aes->key[i+16]);
+         }
+
+         ShadowWrite(&config->aes.key_0.disabled,0);
+      }
+
+      if(run < AES256_EXPANSION_RUNS){
+         SequenceApplyStep(&expandSequence[1],run);
+         return;
+      }
+
+      run -= AES256_EXPANSION_RUNS;
+      if(run == 0){
+         ShadowWrite(&config->aes.key_0.disabled,1);
+      }
+   }
+
+   int block = run / AES256_BLOCK_RUNS;
+   int round = run % AES256_BLOCK_RUNS;
+
+   if(round == 0){
+      // The state of the previous block holds its result until the new block is loaded
+      RegAddr* view = &aesAddr.aes.state_0;
+      if(block > 0){
+         for(int i = 0; i < 16; i++){
+            aes->out[(block - 1) * AES_BLK_SIZE + i] = VersatUnitRead(view[i].addr,0);
+         }
+      }
+      for(int i = 0; i < 16; i++){
+         VersatUnitWrite(view[i].addr,0,aes->in[block * AES_BLK_SIZE + i]);
+      }
+   }
+
+   SequenceApplyStep(&encryptSequence[1],round);
+}
+
+static void FinishAES(VersatJob* job,int run){
+   VersatAESJob* aes = (VersatAESJob*) job->context;
+
+   RegAddr* view = &aesAddr.aes.state_0;
+   for(int i = 0; i < 16; i++){
+      aes->out[(aes->nblocks - 1) * AES_BLK_SIZE + i] = VersatUnitRead(view[i].addr,0);
+   }
+
+   memcpy(expandedKey,aes->key,AES_KEY_SIZE);
+   expandedKeyValid = true;
+}
+
+void VersatAES256ECBSubmit(VersatAESJob* aes,const uint8_t* key,const uint8_t* in,uint8_t* out,size_t nblocks){
+   if(!encryptionReady){
+      // Filling the lookup tables cannot overlap with runs of the queue
+      VersatJobWaitAll();
+      InitVersatAES();
+      InitAESEncryption();
+   }
+
+   aes->in = in;
+   aes->out = out;
+   aes->nblocks = nblocks;
+   memcpy(aes->key,key,AES_KEY_SIZE);
+
+   // Previous jobs of the lane could still change the expanded key
+   aes->expand = !(VersatJobLaneEmpty(VersatJobLane_AES) && expandedKeyValid && memcmp(expandedKey,key,AES_KEY_SIZE) == 0);
+
+   aes->job.configure = ConfigureAESRun;
+   aes->job.finish = FinishAES;
+   aes->job.context = aes;
+   aes->job.runs = (aes->expand ? AES256_EXPANSION_RUNS : 0) + (int) nblocks * AES256_BLOCK_RUNS;
+
+   VersatJobSubmit(&aes->job,VersatJobLane_AES);
+}
+
 /**
  * Used by TestOneMode
  * Intended to run tests
@@ -0,0 +1,209 @@
+#include "versat_crypto.h"
+
+#include "versat_accel.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "unitConfiguration.h"
+
+#include "benes.h"
+
+#if GFBITS == 12
+
+// A row of bits being permuted is a 64x64 bit matrix, streamed as 128 words of 32 bits
+#define STATE_WORDS 128
+#define STATE_BYTES (STATE_WORDS * 4)
+
+// Every layer consumes 256 bytes of condition bits
+#define LAYER_WORDS 64
+#define LAYER_BYTES (LAYER_WORDS * 4)
+#define LAYERS (2 * GFBITS - 1)
+
+static BenesConfig* benes = NULL;
+
+// Layers in the order apply_benes goes through them. Column layers are the ones applied to the transposed matrix
+static const struct {
+   bool column;
+   int lgs;
+} layers[LAYERS] = {
+   {true,0},{true,1},{true,2},{true,3},{true,4},{true,5},
+   {false,0},{false,1},{false,2},{false,3},{false,4},{false,5},
+   {false,4},{false,3},{false,2},{false,1},{false,0},
+   {true,5},{true,4},{true,3},{true,2},{true,1},{true,0}
+};
+
+// VRead and VWrite need 32 bit aligned addresses. Unaligned data goes through these buffers, two of each since
+// a buffer can only be reused after the run that transfers it has finished
+static uint32_t fetchBuffer[2][STATE_WORDS];
+static uint32_t writeBuffer[2][STATE_WORDS];
+static int fetchIndex = 0;
+static int writeIndex = 0;
+
+// Unaligned row written by the last run, copied from its buffer once that run finishes
+static unsigned char* pendingRow = NULL;
+static uint32_t* pendingBuffer = NULL;
+
+/**
+ * Only the pointer to the configuration needs to be set. With the unit disabled it stays idle while other algorithms use the accelerator.
+ * \brief Initializes Versat Benes
+ */
+static void InitVersatBenes(){
+   CryptoAlgosConfig* config = (CryptoAlgosConfig*) accelConfig;
+   benes = &config->benes;
+
+   ConfigureSimpleVReadBare(&benes->input);
+   ConfigureSimpleVWriteBare(&benes->output);
+
+   benes->network.enable = 0;
+   benes->network.load = 0;
+   benes->network.apply = 0;
+   benes->network.column = 0;
+   benes->network.lgs = 0;
+}
+
+static bool IsAligned(const void* ptr){
+   return (((iptr) ptr) & 3) == 0;
+}
+
+/**
+ * \brief Obtains an address the VRead can fetch size bytes of data from
+ */
+static const void* FetchAddress(const void* data,int size){
+   if(IsAligned(data)){
+      return data;
+   }
+
+   uint32_t* buffer = fetchBuffer[fetchIndex];
+   fetchIndex = !fetchIndex;
+   memcpy(buffer,data,size);
+   return buffer;
+}
+
+static void FlushPendingRow(){
+   if(pendingRow){
+      memcpy(pendingRow,pendingBuffer,STATE_BYTES);
+      pendingRow = NULL;
+   }
+}
+
+/**
+ * Like the other units, the accelerator is one run ahead of the software. Data fetched by the VRead in a run only reaches the
+ * BenesLayer unit in the next run, and the matrix streamed to the VWrite in a run is only written to memory in the next run.
+ * \brief Configures and starts one accelerator run
+ * \param fetch memory the VRead starts fetching, NULL to disable it
+ * \param fetchBytes amount of data to fetch
+ * \param load replace the matrix with the one fetched in the previous run, streaming out the current one
+ * \param layer index of the layer to apply with the condition bits fetched in the previous run, -1 for none
+ * \param write row where the matrix streamed in the previous run is written, NULL to disable it
+ */
+static void BenesRun(const void* fetch,int fetchBytes,bool load,int layer,unsigned char* write){
+   if(fetch){
+      ConfigureSimpleVReadShallow(&benes->input,fetchBytes / 4,(int*) FetchAddress(fetch,fetchBytes));
+   } else {
+      benes->input.enableRead = 0;
+   }
+
+   // Runs that only apply a layer are shorter. The VRead delivers the words fetched in the previous run, which can be more
+   // than the ones fetched in this run, and the VWrite needs to receive the same amount of words as the unit outputs
+   bool apply = (layer >= 0);
+   int unitWords = (!load && apply) ? LAYER_WORDS : STATE_WORDS;
+   benes->input.perB = unitWords;
+   benes->input.dutyB = unitWords;
+
+   benes->network.enable = 1;
+   benes->network.load = load;
+   benes->network.apply = apply;
+   if(apply){
+      benes->network.column = layers[layer].column;
+      benes->network.lgs = layers[layer].lgs;
+   }
+
+   unsigned char* dest = write;
+   if(write && !IsAligned(write)){
+      dest = (unsigned char*) writeBuffer[writeIndex];
+   }
+   ConfigureSimpleVWriteShallow(&benes->output,STATE_WORDS,(int*) dest);
+   benes->output.perB = unitWords;
+   if(!write){
+      benes->output.enableWrite = 0;
+   }
+
+   EndAccelerator();
+   FlushPendingRow();
+   StartAccelerator();
+
+   if(dest != write){
+      pendingRow = write;
+      pendingBuffer = writeBuffer[writeIndex];
+      writeIndex = !writeIndex;
+   }
+}
+
+void VersatApplyBenesRows(unsigned char* r,int rows,const unsigned char* bits,int rev){
+   if(rows <= 0){
+      return;
+   }
+
+   VersatJobWaitAll();
+
+   if(!benes){
+      InitVersatBenes();
+   }
+
+   const unsigned char* conditions[LAYERS];
+   for(int i = 0; i < LAYERS; i++){
+      conditions[i] = bits + (rev ? (LAYERS - 1 - i) : i) * LAYER_BYTES;
+   }
+
+   BenesRun(r,STATE_BYTES,false,-1,NULL); // Fetch first row
+
+   for(int row = 0; row < rows; row++){
+      unsigned char* previous = (row > 0) ? r + (row - 1) * STATE_BYTES : NULL;
+
+      // Load row while streaming the previous result, and fetch the conditions of the first layer
+      BenesRun(conditions[0],LAYER_BYTES,true,-1,NULL);
+
+      for(int i = 0; i < LAYERS; i++){
+         // The last layer of a row fetches the next row
+         const unsigned char* fetch = NULL;
+         int fetchBytes = LAYER_BYTES;
+         if(i + 1 < LAYERS){
+            fetch = conditions[i + 1];
+         } else if(row + 1 < rows){
+            fetch = r + (row + 1) * STATE_BYTES;
+            fetchBytes = STATE_BYTES;
+         }
+
+         // The first layer writes the previous result
+         BenesRun(fetch,fetchBytes,false,i,(i == 0) ? previous : NULL);
+      }
+   }
+
+   BenesRun(NULL,0,false,-1,NULL);                                // Stream last result
+   BenesRun(NULL,0,false,-1,r + (rows - 1) * STATE_BYTES);        // Write it
+
+   EndAccelerator();
+   FlushPendingRow();
+
+   benes->input.enableRead = 0;
+   benes->output.enableWrite = 0;
+   benes->network.enable = 0;
+   benes->network.load = 0;
+   benes->network.apply = 0;
+}
+
+#else
+
+// The BenesLayer unit holds the 64x64 bit matrix of a 4096 bit sequence, larger fields use the software network
+void VersatApplyBenesRows(unsigned char* r,int rows,const unsigned char* bits,int rev){
+   for(int row = 0; row < rows; row++){
+      apply_benes(r + row * ((1 << GFBITS) / 8),bits,rev);
+   }
+}
+
+#endif
+
+void VersatApplyBenes(unsigned char* r,const unsigned char* bits,int rev){
+   VersatApplyBenesRows(r,1,bits,rev);
+}
@@ -3,6 +3,11 @@
 
 #include "stdint.h"
 #include "stddef.h"
+#include "stdbool.h"
+
+#include "params.h"
+
+#include "versat_jobs.h"
 
 /** \file
  * Defines the API to execute the crypto algorithms using an accelerator generated by Versat.
@@ -18,6 +23,9 @@
 //! size of hash produced by SHA-256
 #define SHA_DIGEST_SIZE (32)
 
+//! IOb-SoC firmware must implement this function so that the drivers and the testcases can record time taken
+int GetTime();
+
 /**
  * Prepares Versat to perform the SHA algorithm.
  * \brief Initializes Versat SHA
@@ -36,6 +44,13 @@ void InitVersatAES();
  */
 void InitAESEncryption();
 
+/**
+ * The IV is chained into the next block encrypted or decrypted. Functions that do not chain blocks initialize AES again before their next use
+ * \brief Loads the initialization vector of CBC mode
+ * \param iv buffer with the initialization vector. Must contain 16 bytes
+ */
+void LoadIV(uint8_t* iv);
+
 /**
  * Uses Versat accelerator to accelerate calculation of SHA
  * \brief Calculates SHA256 value of input
@@ -45,6 +60,33 @@ void InitAESEncryption();
  */
 void VersatSHA(uint8_t *out, const uint8_t *in, size_t inlen);
 
+/**
+ * State of a SHA calculation performed by the job queue. The last partial block is padded into it, so the caller only needs to keep it valid until the job is done
+ */
+typedef struct{
+  //! Job submitted to the queue, wait on it to obtain the result
+  VersatJob job;
+  //! Where the result is stored when the job finishes
+  uint8_t* out;
+  //! Input, which needs to stay valid until the job is done
+  const uint8_t* in;
+  //! Number of full 64 byte blocks of the input
+  size_t blocks;
+  //! Last partial block followed by the padding, one or two blocks
+  uint8_t padded[128];
+} VersatSHAJob;
+
+/**
+ * Same result as VersatSHA, but returns once the calculation is queued. The CPU can do other work and then use VersatJobWait on the job.
+ * InitVersatSHA must have been previously called
+ * \brief Queues the calculation of the SHA256 value of input
+ * \param sha state of the calculation, needs to stay valid until the job is done
+ * \param out buffer to write result. Needs to be able to store 32 bytes of data
+ * \param in buffer with data, needs to stay valid until the job is done
+ * \param inlen size of in buffer in bytes
+ */
+void VersatSHASubmit(VersatSHAJob* sha,uint8_t *out, const uint8_t *in, size_t inlen);
+
 /**
  * Processes plaintext and stores the encrypt result in encrypted
  * \brief Calculates the AES in ECB mode using a 256 bit key
@@ -54,14 +96,246 @@ void VersatSHA(uint8_t *out, const uint8_t *in, size_t inlen);
  */
 void AES_ECB256(uint8_t* key,uint8_t* plaintext,uint8_t* result);
 
+/**
+ * The counter is incremented before each block is encrypted, like the AES-256 CTR DRBG from NIST does.
+ * The key is only expanded when it differs from the one used by the previous call.
+ * Used by nistkatrng.c in place of the software AES when compiled with VERSAT_DRBG
+ * \brief Encrypts consecutive counter blocks with AES-256 using the Versat accelerator
+ * \param key must contain 32 bytes
+ * \param counter 16 byte big endian counter, left with the value of the last block encrypted
+ * \param out buffer to store nblocks * 16 bytes
+ * \param nblocks number of blocks to generate
+ */
+void VersatAES256CTRBlocks(const uint8_t* key,uint8_t* counter,uint8_t* out,size_t nblocks);
+
+/**
+ * State of an AES-256 ECB encryption performed by the job queue
+ */
+typedef struct{
+  //! Job submitted to the queue, wait on it to obtain the result
+  VersatJob job;
+  //! Copy of the key
+  uint8_t key[AES_KEY_SIZE];
+  //! Blocks to encrypt, which need to stay valid until the job is done
+  const uint8_t* in;
+  //! Where the encrypted blocks are stored
+  uint8_t* out;
+  //! Number of blocks
+  size_t nblocks;
+  //! Whether the job starts by expanding the key
+  bool expand;
+} VersatAESJob;
+
+/**
+ * Same result as AES_ECB256 for each block, but returns once the encryption is queued.
+ * The key is only expanded when it differs from the one expanded by the last AES operation.
+ * Runs on its own lane, so it shares the accelerator runs with a SHA job submitted at the same time.
+ * \brief Queues the encryption of blocks with AES-256 in ECB mode
+ * \param aes state of the encryption, needs to stay valid until the job is done
+ * \param key must contain 32 bytes
+ * \param in nblocks * 16 bytes to encrypt, needs to stay valid until the job is done
+ * \param out buffer to store nblocks * 16 bytes
+ * \param nblocks number of blocks to encrypt, at least 1
+ */
+void VersatAES256ECBSubmit(VersatAESJob* aes,const uint8_t* key,const uint8_t* in,uint8_t* out,size_t nblocks);
+
+/**
+ * Sizes from which crypto_sha256 and crypto_aes256_ecb_encrypt use the accelerator. Below them the fixed cost of configuring and starting Versat is larger than the time it saves.
+ * Both are 0 until CryptoDispatchCalibrate or CryptoDispatchSetThresholds is called, so the accelerator is always used.
+ */
+typedef struct{
+  //! Smallest message, in bytes, hashed by Versat SHA. SIZE_MAX to always use software
+  size_t shaBytes;
+  //! Smallest number of blocks encrypted by Versat AES. SIZE_MAX to always use software
+  size_t aesBlocks;
+} CryptoDispatchThresholds;
+
+/**
+ * Uses Versat when the message is at least the SHA threshold and no SHA job is queued, otherwise the software implementation.
+ * \brief Calculates the SHA256 value of input on the fastest free implementation
+ * \param out buffer to write result. Needs to be able to store 32 bytes of data
+ * \param in buffer with data
+ * \param inlen size of in buffer in bytes
+ */
+void crypto_sha256(uint8_t* out,const uint8_t* in,size_t inlen);
+
+/**
+ * Uses Versat when there are at least as many blocks as the AES threshold and no AES job is queued, otherwise tiny-AES.
+ * Both implementations only expand the key when it changes.
+ * \brief Encrypts blocks with AES-256 in ECB mode on the fastest free implementation
+ * \param key must contain 32 bytes
+ * \param in nblocks * 16 bytes to encrypt
+ * \param out buffer to store nblocks * 16 bytes
+ * \param nblocks number of blocks to encrypt
+ */
+void crypto_aes256_ecb_encrypt(const uint8_t* key,const uint8_t* in,uint8_t* out,size_t nblocks);
+
+/**
+ * Times both implementations of SHA for messages of 0 to 4096 bytes and of AES for 1 to 64 blocks, a few times each,
+ * and sets each threshold to the smallest size from which Versat was faster for every larger size.
+ * Meant to be called once at boot, after InitializeCryptoSide. Waits for the queued jobs and uses 8 KiB of the arena.
+ * \brief Measures the thresholds used by crypto_sha256 and crypto_aes256_ecb_encrypt
+ * \return the thresholds measured
+ */
+CryptoDispatchThresholds CryptoDispatchCalibrate();
+
+/**
+ * \brief Replaces the thresholds, for example with the ones found by a previous calibration
+ * \param thresholds the new thresholds
+ */
+void CryptoDispatchSetThresholds(CryptoDispatchThresholds thresholds);
+
+/**
+ * \brief Obtains the thresholds in use
+ * \return the thresholds
+ */
+CryptoDispatchThresholds CryptoDispatchGetThresholds();
+
+//! Distance in bytes between the rows of the matrix built by VersatMcEliece. Rows start on 64 byte boundaries, so that the VRead bursts do not straddle them
+#define VERSAT_MCELIECE_ROW_STRIDE (((SYS_N / 8) + 63) & ~63)
+
+//! Size of the pk buffer given to VersatMcEliece. Key generation uses it to hold the whole matrix, the public key ends up at the start
+#define VERSAT_MCELIECE_PK_BUFFER_SIZE (PK_NROWS * VERSAT_MCELIECE_ROW_STRIDE)
+
+//! Alignment of the pk buffer for the rows of the matrix to start on 64 byte boundaries. 32 bit alignment is enough for correct results
+#define VERSAT_MCELIECE_PK_BUFFER_ALIGN 64
+
 /**
  * Need to set random seed by calling nist_kat_init before calling this function
  * \brief Performs Generation using the McEliece algorithm
- * \param pk buffer of enough size to store generated public key
+ * \param pk buffer of VERSAT_MCELIECE_PK_BUFFER_SIZE bytes aligned to VERSAT_MCELIECE_PK_BUFFER_ALIGN. The public key is stored in the first bytes
  * \param sk buffer of enough size to store generated secret key
  */
 void VersatMcEliece(unsigned char *pk,unsigned char *sk);
 
+/**
+ * Uses the semi-systematic (f) variant of key generation, which allows the last 32 pivots to be chosen among the following 64 columns.
+ * Almost every attempt succeeds, so the time taken is predictable. Keys are compatible with the same encapsulation and decapsulation functions,
+ * but differ from the keys of VersatMcEliece, so they cannot be checked against the KAT.
+ * Need to set random seed by calling nist_kat_init before calling this function
+ * \brief Performs Generation using the semi-systematic McEliece variant
+ * \param pk buffer of VERSAT_MCELIECE_PK_BUFFER_SIZE bytes aligned to VERSAT_MCELIECE_PK_BUFFER_ALIGN. The public key is stored in the first bytes
+ * \param sk buffer of enough size to store generated secret key
+ */
+void VersatMcElieceSemiSystematic(unsigned char *pk,unsigned char *sk);
+
+#ifdef MCELIECE_BENCHMARK
+/**
+ * Time spent in each phase of McEliece key generation, measured with GetTime.
+ * Values are accumulated over every attempt made by the last call to VersatMcEliece, including the ones that were retried.
+ * Only recorded when compiled with MCELIECE_BENCHMARK, so that other builds do not read the timer during key generation.
+ */
+typedef struct{
+  //! Expanding the seed of an attempt with SHAKE256
+  int seedExpansion;
+  //! Generating the irreducible Goppa polynomial
+  int genpoly;
+  //! Sorting the random values that define the permutation of the support
+  int sort;
+  //! Checking if the first columns of the matrix are independent, before the full matrix is built
+  int systematicCheck;
+  //! Evaluating the Goppa polynomial over the support and filling the matrix with the bit planes
+  int matrixFill;
+  //! Gaussian elimination performed by the accelerator
+  int elimination;
+  //! Computing the control bits of the Benes network from the permutation of the support
+  int controlBits;
+  //! Number of attempts made. Every attempt after the first one is a retry
+  int attempts;
+} McElieceProfile;
+
+/**
+ * \brief Obtains the phase timings of the last call to VersatMcEliece or VersatMcElieceSemiSystematic
+ * \return the time spent in each phase and the number of attempts
+ */
+McElieceProfile GetMcElieceProfile();
+#endif
+
+/**
+ * Same result as the Gaussian elimination of genpoly_gen from sk_gen.c. Used by sk_gen.c when compiled with VERSAT_GENPOLY
+ * \brief Solves the linear system that gives the minimal polynomial of an element using the Versat accelerator
+ * \param out the SYS_T coefficients of the minimal polynomial
+ * \param mat SYS_T + 1 rows of SYS_T field elements, row i holds the i-th power of the element. Not modified
+ * \return 0 on success, -1 if the system does not have a single solution
+ */
+int VersatGenpolySolve(uint16_t* out,uint16_t** mat);
+
+/**
+ * Same result as root from root.c. Used by root.c when compiled with VERSAT_ROOT
+ * \brief Evaluates a polynomial at every element of the support using the Versat accelerator
+ * \param out SYS_N values of the polynomial. Should be 32 bit aligned, otherwise it goes through a copy
+ * \param f the SYS_T + 1 coefficients of the polynomial, lowest degree first
+ * \param L SYS_N field elements. Should be 32 bit aligned, otherwise it goes through a copy
+ */
+void VersatRoot(uint16_t* out,const uint16_t* f,const uint16_t* L);
+
+/**
+ * Used by fips202.c in place of its software permutation when compiled with VERSAT_KECCAK
+ * \brief Applies the Keccak-f[1600] permutation using the Versat accelerator
+ * \param state the 25 lanes of the Keccak state. Needs to be 32 bit aligned
+ */
+void VersatKeccakF1600(uint64_t* state);
+
+/**
+ * For each block, XORs it into the first rate bytes of the state and applies the permutation.
+ * The state is only transferred at the start and at the end, and blocks are fetched while the previous one is permuted.
+ * \brief Absorbs full blocks into a Keccak state using the Versat accelerator
+ * \param state the 25 lanes of the Keccak state. Needs to be 32 bit aligned
+ * \param rate size of a block in bytes (136 for SHAKE256)
+ * \param m nblocks * rate bytes to absorb. No alignment required
+ * \param nblocks number of blocks to absorb
+ */
+void VersatKeccakAbsorbBlocks(uint64_t* state,uint32_t rate,const uint8_t* m,size_t nblocks);
+
+/**
+ * For each block, applies the permutation and outputs the first rate bytes of the state
+ * \brief Squeezes full blocks from a Keccak state using the Versat accelerator
+ * \param out buffer of nblocks * rate bytes. No alignment required
+ * \param nblocks number of blocks to squeeze
+ * \param state the 25 lanes of the Keccak state. Needs to be 32 bit aligned
+ * \param rate size of a block in bytes (136 for SHAKE256)
+ */
+void VersatKeccakSqueezeBlocks(uint8_t* out,size_t nblocks,uint64_t* state,uint32_t rate);
+
+/**
+ * Same result as apply_benes from benes.c
+ * \brief Applies the Benes network of McEliece to a sequence of bits using the Versat accelerator
+ * \param r (1 << GFBITS) / 8 bytes to permute, replaced by the result
+ * \param bits condition bits of the network
+ * \param rev 0 for normal application, !0 for inverse
+ */
+void VersatApplyBenes(unsigned char* r,const unsigned char* bits,int rev);
+
+/**
+ * Rows are loaded into the accelerator while the previous one is being written back, which is faster than applying them one at a time.
+ * The BenesLayer unit only handles GFBITS 12, larger fields fall back to apply_benes.
+ * Used by support_gen from benes.c when compiled with VERSAT_BENES
+ * \brief Applies the same Benes network to several contiguous sequences of bits
+ * \param r rows * (1 << GFBITS) / 8 bytes to permute, replaced by the result
+ * \param rows number of sequences
+ * \param bits condition bits of the network
+ * \param rev 0 for normal application, !0 for inverse
+ */
+void VersatApplyBenesRows(unsigned char* r,int rows,const unsigned char* bits,int rev);
+
+/**
+ * Runs a bitonic sorting network: the compare-exchanges of distance up to 32 are memory to memory passes on the accelerator, larger ones are done in software.
+ * Neither depend on the values being sorted. Sequences that are small or whose size is not a power of two are sorted by uint64_sort.
+ * Values need to be smaller than 2^63, like for uint64_sort.
+ * \brief Sorts 64 bit values in ascending order using the Versat accelerator
+ * \param x values to sort, 32 bit aligned
+ * \param n number of values
+ */
+void VersatSortU64(uint64_t* x,long long n);
+
+/**
+ * Same as VersatSortU64, falling back to int32_sort. Used by controlbits.c when compiled with VERSAT_SORT
+ * \brief Sorts signed 32 bit values in ascending order using the Versat accelerator
+ * \param x values to sort
+ * \param n number of values
+ */
+void VersatSortI32(int32_t* x,long long n);
+
 /**
  * \brief Converts bytes into hexadecimal string
  * \param text bytes to convert
@@ -72,8 +346,9 @@ void VersatMcEliece(unsigned char *pk,unsigned char *sk);
 char* GetHexadecimal(const char* text,char* buffer,int str_size);
 
 /**
+ * Can decode in place, with buffer equal to str. KAT values are decoded this way, so that the results are compared in binary without copying them
  * \brief Converts hexadecimal string to bytes
- * \param buffer to hold result. Needs to have space to store str/2 bytes
+ * \param buffer to hold result. Needs to have space to store str/2 bytes. Can be str itself
  * \param str C-Style string that contains hexadecimal characters. First non hexadecimal character ends conversion
  * \result number of bytes converted
  */
@@ -0,0 +1,168 @@
+#include "versat_crypto.h"
+
+#include <string.h>
+
+#include "crypto_tests.h"
+#include "crypto_benchmark.h"
+#include "crypto/aes.h"
+#include "crypto/sha2.h"
+
+#include "arena.h"
+
+// Sizes timed by the calibration, a threshold is one of them
+static const size_t calibrationSHABytes[] = {0,32,64,128,256,1024,4096};
+static const size_t calibrationAESBlocks[] = {1,2,4,8,16,32,64};
+
+#define CALIBRATION_SHA_SIZES (sizeof(calibrationSHABytes) / sizeof(calibrationSHABytes[0]))
+#define CALIBRATION_AES_SIZES (sizeof(calibrationAESBlocks) / sizeof(calibrationAESBlocks[0]))
+#define CALIBRATION_DATA_SIZE 4096
+#define CALIBRATION_RUNS 3
+
+static CryptoDispatchThresholds thresholds = {0,0};
+
+static bool shaReady = false;
+
+// The software path keeps the expanded key, like the accelerator does
+static struct AES_ctx softwareContext;
+static uint8_t softwareKey[AES_KEY_SIZE];
+static bool softwareKeyValid = false;
+
+static void SoftwareSHA(uint8_t* out,const uint8_t* in,size_t inlen){
+   sha256(out,in,inlen);
+}
+
+static void VersatDispatchSHA(uint8_t* out,const uint8_t* in,size_t inlen){
+   if(!shaReady){
+      InitVersatSHA();
+      shaReady = true;
+   }
+
+   VersatSHA(out,in,inlen);
+}
+
+static void SoftwareAES(const uint8_t* key,const uint8_t* in,uint8_t* out,size_t nblocks){
+   if(!softwareKeyValid || memcmp(softwareKey,key,AES_KEY_SIZE) != 0){
+      memcpy(softwareKey,key,AES_KEY_SIZE);
+      AES_init_ctx(&softwareContext,softwareKey);
+      softwareKeyValid = true;
+   }
+
+   memmove(out,in,nblocks * AES_BLK_SIZE);
+   for(size_t i = 0; i < nblocks; i++){
+      AES_ECB_encrypt(&softwareContext,&out[i * AES_BLK_SIZE]);
+   }
+}
+
+static void VersatDispatchAES(const uint8_t* key,const uint8_t* in,uint8_t* out,size_t nblocks){
+   VersatAESJob aes;
+
+   VersatAES256ECBSubmit(&aes,key,in,out,nblocks);
+   VersatJobWait(&aes.job);
+}
+
+void crypto_sha256(uint8_t* out,const uint8_t* in,size_t inlen){
+   // A busy lane would make the call wait for the jobs queued before it
+   if(inlen >= thresholds.shaBytes && VersatJobLaneEmpty(VersatJobLane_SHA)){
+      VersatDispatchSHA(out,in,inlen);
+   } else {
+      SoftwareSHA(out,in,inlen);
+   }
+}
+
+void crypto_aes256_ecb_encrypt(const uint8_t* key,const uint8_t* in,uint8_t* out,size_t nblocks){
+   if(nblocks == 0){
+      return;
+   }
+
+   if(nblocks >= thresholds.aesBlocks && VersatJobLaneEmpty(VersatJobLane_AES)){
+      VersatDispatchAES(key,in,out,nblocks);
+   } else {
+      SoftwareAES(key,in,out,nblocks);
+   }
+}
+
+// The smallest size from which the accelerator was faster for every larger size, SIZE_MAX if it was not faster for the largest
+static size_t Crossover(const size_t* sizes,const uint32_t* versat,const uint32_t* software,size_t count){
+   size_t threshold = SIZE_MAX;
+   for(size_t i = count; i > 0; i--){
+      if(versat[i - 1] >= software[i - 1]){
+         break;
+      }
+      threshold = sizes[i - 1];
+   }
+
+   return threshold;
+}
+
+static uint32_t Shortest(uint32_t time,uint32_t shortest){
+   return (time < shortest) ? time : shortest;
+}
+
+CryptoDispatchThresholds CryptoDispatchCalibrate(){
+   uint32_t shaVersat[CALIBRATION_SHA_SIZES];
+   uint32_t shaSoftware[CALIBRATION_SHA_SIZES];
+   uint32_t aesVersat[CALIBRATION_AES_SIZES];
+   uint32_t aesSoftware[CALIBRATION_AES_SIZES];
+
+   int mark = MarkArena(globalArena);
+
+   uint8_t key[AES_KEY_SIZE];
+   uint8_t* in = PushArray(globalArena,CALIBRATION_DATA_SIZE,uint8_t);
+   uint8_t* out = PushArray(globalArena,CALIBRATION_DATA_SIZE,uint8_t);
+   BenchmarkFillInput(key,in,CALIBRATION_DATA_SIZE);
+
+   // The accelerator needs to be free for the calibration
+   VersatJobWaitAll();
+
+   // The first run of each size is a warm-up. The shortest of the other runs leaves out the ones slowed down by cache misses
+   for(size_t i = 0; i < CALIBRATION_SHA_SIZES; i++){
+      shaVersat[i] = UINT32_MAX;
+      shaSoftware[i] = UINT32_MAX;
+
+      for(int run = 0; run <= CALIBRATION_RUNS; run++){
+         int start = GetTime();
+         VersatDispatchSHA(out,in,calibrationSHABytes[i]);
+         int middle = GetTime();
+         SoftwareSHA(out,in,calibrationSHABytes[i]);
+         int end = GetTime();
+
+         if(run > 0){
+            shaVersat[i] = Shortest((uint32_t) (middle - start),shaVersat[i]);
+            shaSoftware[i] = Shortest((uint32_t) (end - middle),shaSoftware[i]);
+         }
+      }
+   }
+
+   for(size_t i = 0; i < CALIBRATION_AES_SIZES; i++){
+      aesVersat[i] = UINT32_MAX;
+      aesSoftware[i] = UINT32_MAX;
+
+      for(int run = 0; run <= CALIBRATION_RUNS; run++){
+         int start = GetTime();
+         VersatDispatchAES(key,in,out,calibrationAESBlocks[i]);
+         int middle = GetTime();
+         SoftwareAES(key,in,out,calibrationAESBlocks[i]);
+         int end = GetTime();
+
+         if(run > 0){
+            aesVersat[i] = Shortest((uint32_t) (middle - start),aesVersat[i]);
+            aesSoftware[i] = Shortest((uint32_t) (end - middle),aesSoftware[i]);
+         }
+      }
+   }
+
+   PopArena(globalArena,mark);
+
+   thresholds.shaBytes = Crossover(calibrationSHABytes,shaVersat,shaSoftware,CALIBRATION_SHA_SIZES);
+   thresholds.aesBlocks = Crossover(calibrationAESBlocks,aesVersat,aesSoftware,CALIBRATION_AES_SIZES);
+
+   return thresholds;
+}
+
+void CryptoDispatchSetThresholds(CryptoDispatchThresholds newThresholds){
+   thresholds = newThresholds;
+}
+
+CryptoDispatchThresholds CryptoDispatchGetThresholds(){
+   return thresholds;
+}
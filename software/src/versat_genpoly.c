@@ -0,0 +1,202 @@
+#include "versat_crypto.h"
+
+#include "versat_accel.h"
+#include "versat_shadow.h"
+
+#include <stdbool.h>
+
+#include "unitConfiguration.h"
+
+#include "crypto_declassify.h"
+#include "crypto_uint16.h"
+#include "gf.h"
+#include "arena.h"
+
+// Prevents "cast increases required alignment" warnings by gcc
+#define CAST_PTR(TYPE,PTR) ((TYPE) ((void*) (PTR)))
+
+// Row k of the transposed matrix holds mat[c][k] for c = 0 to SYS_T, padded with a zero to a whole number of words
+#define ROW_GF (SYS_T + 2)
+#define ROW_WORDS (ROW_GF / 2)
+
+// Operation applied to one row streamed by the VRead
+typedef struct{
+   gf* row;          // NULL for an accumulation that only scales the pivot row
+   bool accumulate;  // Add the row to the pivot row instead of adding the pivot row to it
+   uint32_t mask;    // Accumulations only add the row when the mask is set
+   gf scale;         // Accumulations scale the pivot row by this value after adding the row
+   gf product;       // The other rows get the pivot row multiplied by this value added to them
+} RowOp;
+
+static GenpolyConfig* genpoly = NULL;
+static void* pivotAddr;
+
+/**
+ * Only the pointer to the configuration needs to be set. The pivot memory is only configured while an elimination is running.
+ * \brief Initializes Versat Genpoly
+ */
+static void InitVersatGenpoly(){
+   CryptoAlgosConfig* config = (CryptoAlgosConfig*) accelConfig;
+   genpoly = &config->genpoly;
+   pivotAddr = (void*) TOP_genpoly_pivot_addr;
+
+   ConfigureSimpleVReadBare(&genpoly->row);
+   ConfigureSimpleVWriteBare(&genpoly->writer);
+
+   genpoly->scale.gf13 = (GFBITS == 13);
+   genpoly->product.gf13 = (GFBITS == 13);
+}
+
+/**
+ * \brief Configures the pivot memory to stream a row every run, or leaves it like after reset so that it does not lengthen the runs of other algorithms
+ * \param words size of a row in words, 0 to leave the memory idle
+ */
+static void ConfigurePivot(int words){
+   int size = (words > 0) ? words + 1 : 0;
+   int enable = (words > 0);
+
+   genpoly->pivot.iterA = enable;
+   genpoly->pivot.incrA = enable;
+   genpoly->pivot.iterB = enable;
+   genpoly->pivot.incrB = enable;
+   genpoly->pivot.perA = size;
+   genpoly->pivot.dutyA = size;
+   genpoly->pivot.perB = size;
+   genpoly->pivot.dutyB = size;
+   ShadowWrite(&genpoly->pivot.in0_wr,0);
+}
+
+static crypto_uint16 gf_is_zero_declassify(gf t) {
+   crypto_uint16 mask = crypto_uint16_zero_mask(t);
+   crypto_declassify(&mask, sizeof mask);
+   return mask;
+}
+
+/**
+ * Like the other units, the accelerator is one run ahead of the software. A row fetched in a run is processed in the next run
+ * and, if the pivot row was added to it, written back to memory in the run after that.
+ * \brief Configures and starts one accelerator run
+ * \param fetch row the VRead starts fetching, NULL to disable it
+ * \param compute operation applied to the row fetched in the previous run, NULL for none
+ * \param write row where the row processed in the previous run is written, NULL to disable it
+ */
+static void GenpolyRun(gf* fetch,const RowOp* compute,gf* write){
+   if(fetch){
+      ConfigureSimpleVReadShallow(&genpoly->row,ROW_WORDS,CAST_PTR(int*,fetch));
+   } else {
+      genpoly->row.enableRead = 0;
+   }
+
+   bool accumulate = (compute && compute->accumulate);
+   ShadowWrite(&genpoly->pivot.in0_wr,accumulate);
+   ShadowWrite(&genpoly->mask.constant,accumulate ? compute->mask : 0);
+   ShadowWrite(&genpoly->scale.scalar,accumulate ? compute->scale : 1);
+   ShadowWrite(&genpoly->product.scalar,(compute && !accumulate) ? compute->product : 0);
+
+   ConfigureSimpleVWriteShallow(&genpoly->writer,ROW_WORDS,CAST_PTR(int*,write));
+   if(!write){
+      genpoly->writer.enableWrite = 0;
+   }
+
+   EndAccelerator();
+   StartAccelerator();
+}
+
+/**
+ * Operations that add a multiple of the pivot row write the row back two runs after fetching it,
+ * so every row is up to date in memory once this function returns.
+ * \brief Applies a sequence of operations with the pivot row loaded in the accelerator
+ */
+static void RunRowOps(const RowOp* ops,int n){
+   for(int i = 0; i < n + 2; i++){
+      gf* fetch = (i < n) ? ops[i].row : NULL;
+      const RowOp* compute = (i >= 1 && i <= n) ? &ops[i - 1] : NULL;
+      gf* write = (i >= 2 && !ops[i - 2].accumulate) ? ops[i - 2].row : NULL;
+
+      GenpolyRun(fetch,compute,write);
+   }
+
+   EndAccelerator();
+
+   genpoly->row.enableRead = 0;
+   genpoly->writer.enableWrite = 0;
+   ShadowWrite(&genpoly->pivot.in0_wr,0);
+}
+
+// The accumulations into the pivot row only change its diagonal element in a way the software can follow,
+// so the masks, the inverse and the failure check are known before the rows are streamed
+int VersatGenpolySolve(uint16_t* out,uint16_t** mat){
+   int i, j, k;
+
+   VersatJobWaitAll();
+
+   if(!genpoly){
+      InitVersatGenpoly();
+   }
+
+   int mark = MarkArena(globalArena);
+
+   gf* rows = PushArray(globalArena,SYS_T * ROW_GF,gf);
+   RowOp* ops = PushArray(globalArena,2 * SYS_T,RowOp);
+
+   for(k = 0; k < SYS_T; k++){
+      for(i = 0; i < SYS_T + 1; i++){
+         rows[k * ROW_GF + i] = mat[i][k];
+      }
+      rows[k * ROW_GF + SYS_T + 1] = 0;
+   }
+
+   EndAccelerator();
+   ConfigurePivot(ROW_WORDS);
+
+   for(j = 0; j < SYS_T; j++){
+      gf* pivot = rows + j * ROW_GF;
+
+      VersatMemoryCopy(pivotAddr,CAST_PTR(int*,pivot),ROW_WORDS * sizeof(int));
+
+      int n = 0;
+      gf diagonal = pivot[j];
+      for(k = j + 1; k < SYS_T; k++){
+         gf mask = gf_iszero(diagonal);
+         diagonal ^= rows[k * ROW_GF + j] & mask;
+
+         ops[n++] = (RowOp){.row = rows + k * ROW_GF,.accumulate = true,.mask = mask * 0x00010001,.scale = 1};
+      }
+
+      if(n == 0){
+         ops[n++] = (RowOp){.row = NULL,.accumulate = true,.mask = 0,.scale = 1};
+      }
+
+      if(gf_is_zero_declassify(diagonal)){ // return if not systematic
+         ConfigurePivot(0);
+         PopArena(globalArena,mark);
+         return -1;
+      }
+
+      // The last accumulation also scales the pivot row so that its diagonal element becomes one
+      ops[n - 1].scale = gf_inv(diagonal);
+
+      for(k = 0; k < SYS_T; k++){
+         if(k != j){
+            ops[n++] = (RowOp){.row = rows + k * ROW_GF,.accumulate = false,.product = rows[k * ROW_GF + j]};
+         }
+      }
+
+      RunRowOps(ops,n);
+
+      uint32_t* pivot_int = CAST_PTR(uint32_t*,pivot);
+      for(i = 0; i < ROW_WORDS; i++){
+         pivot_int[i] = VersatUnitRead(pivotAddr,i);
+      }
+   }
+
+   ConfigurePivot(0);
+
+   for(i = 0; i < SYS_T; i++){
+      out[i] = rows[i * ROW_GF + SYS_T];
+   }
+
+   PopArena(globalArena,mark);
+
+   return 0;
+}
@@ -0,0 +1,123 @@
+#include "versat_jobs.h"
+
+#include "versat_accel.h"
+
+#include <stddef.h>
+
+// The jobs of a lane form a singly linked list, the head is the job that owns the units of the lane
+typedef struct{
+   VersatJob* head;
+   VersatJob* tail;
+} Lane;
+
+static Lane lanes[VersatJobLane_Count];
+
+static bool QueueEmpty(){
+   for(int i = 0; i < VersatJobLane_Count; i++){
+      if(lanes[i].head){
+         return false;
+      }
+   }
+   return true;
+}
+
+// Moves the head job of a lane to its next run, finishing it and moving on to the next job after its last run
+static void AdvanceLane(Lane* lane){
+   VersatJob* job = lane->head;
+   if(!job){
+      return;
+   }
+
+   job->run += 1;
+   if(job->run < job->runs){
+      return;
+   }
+
+   if(job->finish){
+      job->finish(job,job->runs);
+   }
+
+   lane->head = job->next;
+   if(!lane->head){
+      lane->tail = NULL;
+   } else {
+      lane->head->run = 0;
+   }
+
+   job->next = NULL;
+   job->done = true;
+}
+
+// Every head job configures its part of the run before the accelerator is started
+static void StartRun(){
+   for(int i = 0; i < VersatJobLane_Count; i++){
+      VersatJob* job = lanes[i].head;
+      if(job){
+         job->configure(job,job->run);
+      }
+   }
+
+   StartAccelerator();
+}
+
+void VersatJobSubmit(VersatJob* job,VersatJobLane lane){
+   job->run = -1;
+   job->done = false;
+   job->next = NULL;
+
+   bool idle = QueueEmpty();
+
+   Lane* l = &lanes[lane];
+   if(l->tail){
+      l->tail->next = job;
+      l->tail = job;
+   } else {
+      l->head = job;
+      l->tail = job;
+   }
+
+   if(idle){
+      job->run = 0;
+
+      // Blocking functions always leave the accelerator idle, but make sure their last run has completed
+      EndAccelerator();
+      StartRun();
+   }
+}
+
+bool VersatJobPoll(){
+   if(QueueEmpty()){
+      return false;
+   }
+
+   EndAccelerator();
+
+   for(int i = 0; i < VersatJobLane_Count; i++){
+      AdvanceLane(&lanes[i]);
+   }
+
+   if(QueueEmpty()){
+      return false;
+   }
+
+   StartRun();
+   return true;
+}
+
+bool VersatJobLaneEmpty(VersatJobLane lane){
+   return (lanes[lane].head == NULL);
+}
+
+bool VersatJobDone(VersatJob* job){
+   return job->done;
+}
+
+void VersatJobWait(VersatJob* job){
+   while(!job->done){
+      VersatJobPoll();
+   }
+}
+
+void VersatJobWaitAll(){
+   while(VersatJobPoll());
+}
@@ -0,0 +1,106 @@
+#ifndef INCLUDED_VERSAT_JOBS
+#define INCLUDED_VERSAT_JOBS
+
+#include "stdbool.h"
+
+/** \file
+ * Defines a small queue of accelerator jobs, so that the CPU can do other work while Versat runs.
+ * A job is a sequence of accelerator runs described by the caller. Jobs are submitted to a lane and executed in the order they are submitted to it,
+ * the first run of a job is started as soon as the last run of the previous one completes.
+ * Every accelerator run starts all the units of CryptoAlgos, so the jobs at the head of each lane share the runs: each run is configured by all of them.
+ * A run lasts as long as the slowest unit, so a block of SHA and a round of AES take about as long together as a block of SHA alone.
+ * The accelerator does not raise an interrupt when a run completes, so the queue only advances when it is polled.
+ * While the queue is not empty, the accelerator belongs to it: the blocking SHA and AES functions of versat_crypto.h must only be called after VersatJobWaitAll.
+ * The McEliece, Keccak, Sort, Benes, Root and Genpoly drivers call VersatJobWaitAll themselves before using the accelerator, so they are not
+ * time-multiplexed with queued jobs.
+ */
+
+/**
+ * Each lane owns a set of units that the jobs of the other lanes do not touch.
+ * The units of a lane keep running during the runs where it has no job, so a job must not rely on their state from before its first run.
+ */
+typedef enum{
+  //! The units of the SHA module
+  VersatJobLane_SHA,
+  //! The units of the FullAES module
+  VersatJobLane_AES,
+  //! Number of lanes
+  VersatJobLane_Count
+} VersatJobLane;
+
+typedef struct VersatJob VersatJob;
+
+/**
+ * \brief Function called by the queue for a job
+ * \param job the job, so that the function can reach its context
+ * \param run index of the run about to be started, counting from 0
+ */
+typedef void (*VersatJobFunction)(VersatJob* job,int run);
+
+/**
+ * Descriptor of a job. The caller owns the memory, which needs to stay valid until the job is done.
+ * Only configure, finish, context and runs are set by the caller, the other members are managed by the queue.
+ */
+struct VersatJob{
+  //! Called before each run is started, after the previous run has completed. Configures the accelerator for the run
+  VersatJobFunction configure;
+  //! Called once after the last run has completed, with run equal to runs. Reads the results and disables the units. Can be NULL
+  VersatJobFunction finish;
+  //! Data used by configure and finish
+  void* context;
+  //! Number of accelerator runs, at least 1
+  int runs;
+
+  //! Index of the run in progress, -1 while waiting for the first run
+  int run;
+  //! Set by the queue once finish has been called
+  volatile bool done;
+  //! Next job in the queue
+  VersatJob* next;
+};
+
+/**
+ * If the queue is empty the first run of the job is started before returning.
+ * Otherwise the job starts after the ones already queued in the lane, and if the lane is empty it joins the next run of the other lanes.
+ * \brief Adds a job to the end of a lane
+ * \param job descriptor with configure, context and runs set
+ * \param lane the lane that owns the units used by the job
+ */
+void VersatJobSubmit(VersatJob* job,VersatJobLane lane);
+
+/**
+ * Waits for the run in progress to complete, then starts one run configured by the job at the head of each lane:
+ * the next run of the current job, or the first run of the next job once the current one is done.
+ * Calling it often keeps the accelerator busy, the time it waits is at most the duration of one run.
+ * \brief Advances the queue by one run
+ * \return true while there are jobs in the queue
+ */
+bool VersatJobPoll();
+
+/**
+ * \brief Checks if a lane has no jobs, neither running nor waiting
+ * \param lane the lane to check
+ * \return true if the lane is empty
+ */
+bool VersatJobLaneEmpty(VersatJobLane lane);
+
+/**
+ * \brief Checks if a job has completed, without waiting
+ * \param job a submitted job
+ * \return true once the finish function of the job has been called
+ */
+bool VersatJobDone(VersatJob* job);
+
+/**
+ * Jobs submitted before it to the same lane are completed as well
+ * \brief Polls the queue until a job completes
+ * \param job a submitted job
+ */
+void VersatJobWait(VersatJob* job);
+
+/**
+ * \brief Polls the queue until every job completes, leaving the accelerator free for the blocking functions
+ */
+void VersatJobWaitAll();
+
+#endif // INCLUDED_VERSAT_JOBS
@@ -0,0 +1,186 @@
+#include "versat_crypto.h"
+
+#include "versat_accel.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "unitConfiguration.h"
+
+// The Keccak state has 25 lanes of 64 bits, streamed by the unit as 50 words of 32 bits (low half first)
+#define STATE_WORDS 50
+
+static KeccakConfig* keccak = NULL;
+
+// VRead and VWrite access memory while the accelerator is running, so message and output blocks go through these word aligned buffers.
+// There are two of each since the accelerator transfers one block while the software prepares or consumes the other.
+static uint32_t absorbBuffer[2][STATE_WORDS];
+static uint32_t squeezeBuffer[2][STATE_WORDS];
+
+/**
+ * Only the pointer to the configuration needs to be set. With everything disabled the units stay idle while other algorithms use the accelerator.
+ * \brief Initializes Versat Keccak
+ */
+static void InitVersatKeccak(){
+   CryptoAlgosConfig* config = (CryptoAlgosConfig*) accelConfig;
+   keccak = &config->keccak;
+
+   ConfigureSimpleVReadBare(&keccak->absorb);
+   ConfigureSimpleVWriteBare(&keccak->squeeze);
+
+   keccak->permutation.enable = 0;
+   keccak->permutation.clear = 0;
+   keccak->permutation.absorbWords = 0;
+   keccak->permutation.permute = 0;
+}
+
+/**
+ * Like the other units, the accelerator is one run ahead of the software. Data fetched by the VRead in a run only reaches the
+ * permutation unit in the next run, and the state streamed to the VWrite in a run is only written to memory in the next run.
+ * \brief Configures and starts one accelerator run
+ * \param fetch memory the VRead starts fetching, NULL to disable it
+ * \param fetchWords number of words to fetch
+ * \param clear zero the state before absorbing
+ * \param absorbWords number of words fetched in the previous run that are XORed into the state
+ * \param permute apply the permutation after absorbing
+ * \param write memory where the words streamed in the previous run are written, NULL to disable it
+ * \param writeWords number of words to write
+ */
+static void KeccakRun(const void* fetch,int fetchWords,bool clear,int absorbWords,bool permute,void* write,int writeWords){
+   if(fetch){
+      ConfigureSimpleVReadShallow(&keccak->absorb,fetchWords,(int*) fetch);
+   } else {
+      keccak->absorb.enableRead = 0;
+   }
+
+   // The unit receives the words fetched in the previous run, which can be more than the ones fetched in this run
+   if(absorbWords > 0){
+      keccak->absorb.perB = absorbWords;
+      keccak->absorb.dutyB = absorbWords;
+   }
+
+   keccak->permutation.enable = 1;
+   keccak->permutation.clear = clear;
+   keccak->permutation.absorbWords = absorbWords;
+   keccak->permutation.permute = permute;
+
+   // The unit always streams the full state, the amount written to memory is controlled by the memory side
+   ConfigureSimpleVWriteShallow(&keccak->squeeze,writeWords,(int*) write);
+   keccak->squeeze.perB = STATE_WORDS;
+   if(!write){
+      keccak->squeeze.enableWrite = 0;
+   }
+
+   EndAccelerator();
+   StartAccelerator();
+}
+
+/**
+ * Leaves the accelerator stopped and the Keccak units idle, so that they do not interfere with other algorithms
+ * \brief Finishes a sequence of Keccak runs
+ */
+static void KeccakEnd(){
+   EndAccelerator();
+
+   keccak->absorb.enableRead = 0;
+   keccak->squeeze.enableWrite = 0;
+   keccak->permutation.enable = 0;
+   keccak->permutation.clear = 0;
+   keccak->permutation.absorbWords = 0;
+   keccak->permutation.permute = 0;
+}
+
+void VersatKeccakF1600(uint64_t* state){
+   VersatJobWaitAll();
+
+   if(!keccak){
+      InitVersatKeccak();
+   }
+
+   KeccakRun(state,STATE_WORDS,false,0,false,NULL,0);        // Fetch state
+   KeccakRun(NULL,0,true,STATE_WORDS,true,NULL,0);           // Load state into the unit and permute
+   KeccakRun(NULL,0,false,0,false,NULL,0);                   // Stream permuted state
+   KeccakRun(NULL,0,false,0,false,state,STATE_WORDS);        // Write it back
+
+   KeccakEnd();
+}
+
+void VersatKeccakAbsorbBlocks(uint64_t* state,uint32_t rate,const uint8_t* m,size_t nblocks){
+   int rateWords = rate / 4;
+
+   if(nblocks == 0){
+      return;
+   }
+
+   VersatJobWaitAll();
+
+   if(!keccak){
+      InitVersatKeccak();
+   }
+
+   KeccakRun(state,STATE_WORDS,false,0,false,NULL,0); // Fetch state
+
+   // Load state into the unit while the first block is fetched
+   memcpy(absorbBuffer[0],m,rate);
+   KeccakRun(absorbBuffer[0],rateWords,true,STATE_WORDS,false,NULL,0);
+
+   for(size_t i = 0; i < nblocks; i++){
+      // Absorb block i and permute while block i + 1 is fetched.
+      // Block i + 1 goes into the buffer of block i - 1, whose fetch has already finished.
+      uint32_t* next = NULL;
+      if(i + 1 < nblocks){
+         next = absorbBuffer[(i + 1) & 1];
+         memcpy(next,m + (i + 1) * rate,rate);
+      }
+
+      KeccakRun(next,rateWords,false,rateWords,true,NULL,0);
+   }
+
+   KeccakRun(NULL,0,false,0,false,NULL,0);                   // Stream final state
+   KeccakRun(NULL,0,false,0,false,state,STATE_WORDS);        // Write it back
+
+   KeccakEnd();
+}
+
+void VersatKeccakSqueezeBlocks(uint8_t* out,size_t nblocks,uint64_t* state,uint32_t rate){
+   int rateWords = rate / 4;
+
+   if(nblocks == 0){
+      return;
+   }
+
+   VersatJobWaitAll();
+
+   if(!keccak){
+      InitVersatKeccak();
+   }
+
+   KeccakRun(state,STATE_WORDS,false,0,false,NULL,0);        // Fetch state
+   KeccakRun(NULL,0,true,STATE_WORDS,true,NULL,0);           // Load state into the unit and permute
+
+   for(size_t i = 0; i < nblocks; i++){
+      bool last = (i + 1 == nblocks);
+
+      // Stream block i, permuting again only if more blocks are needed. The VWrite writes block i - 1 at the same time.
+      KeccakRun(NULL,0,false,0,!last,(i > 0) ? squeezeBuffer[(i - 1) & 1] : NULL,rateWords);
+
+      // The run that wrote block i - 2 has finished
+      if(i > 1){
+         memcpy(out + (i - 2) * rate,squeezeBuffer[i & 1],rate);
+      }
+   }
+
+   // The last block is the final state, written directly to it
+   KeccakRun(NULL,0,false,0,false,state,STATE_WORDS);
+
+   if(nblocks > 1){
+      memcpy(out + (nblocks - 2) * rate,squeezeBuffer[nblocks & 1],rate);
+   }
+
+   KeccakEnd();
+
+   out += (nblocks - 1) * rate;
+   for(uint32_t i = 0; i < rate; i++){
+      out[i] = (uint8_t) (state[i / 8] >> (8 * (i % 8)));
+   }
+}
@@ -1,6 +1,7 @@
 #include "versat_crypto.h"
 
 #include "versat_accel.h"
+#include "versat_shadow.h"
 #include "unitConfiguration.h"
 
 #include <string.h>
@@ -15,30 +16,52 @@
 #include "pk_gen.h"
 #include "sk_gen.h"
 #include "root.h"
-#include "uint64_sort.h"
 #include "util.h"
 #include "crypto_hash.h"
 #include "decrypt.h"
 #include "randombytes.h"
 
+#include "vec.h"
+
 #include "arena.h"
 
 // Prevents "cast increases required alignment" warnings by gcc
 // When mat is allocated in such a way that rows are guaranteed to be aligned
 #define CAST_PTR(TYPE,PTR) ((TYPE) ((void*) (PTR)))
 
-static McElieceConfig* vec;
+// The time of each phase is only recorded by benchmark builds. PROFILE_BEGIN starts timing a phase and PROFILE_END adds
+// the time since then to the field of the profile with the same name
+#ifdef MCELIECE_BENCHMARK
+static McElieceProfile profile;
+#define PROFILE_BEGIN(PHASE) int PHASE##Start = GetTime()
+#define PROFILE_END(PHASE) profile.PHASE += GetTime() - PHASE##Start
+#else
+#define PROFILE_BEGIN(PHASE)
+#define PROFILE_END(PHASE)
+#endif
+
+static McElieceConfig* eliece;
 static void* matAddr;
+static int rowWords; // Size in words of the rows currently being processed by the accelerator
 
 #define SBYTE (SYS_N / 8)
 #define SINT (SBYTE / 4)
 
+// Rows are transferred as 32 bit words and the systematic check works on the first PK_NROWS columns as whole words
+#if (SBYTE % 4) || (PK_ROW_BYTES % 4) || (PK_NROWS % 32)
+#error "Versat McEliece needs rows and public key rows to be multiples of 4 bytes and PK_NROWS to be a multiple of 32"
+#endif
+
+// Matrix rows are stored rotated: the systematic part (the public key row) comes first and the PK_NROWS / 8 bytes of the
+// identity part come last. This way the last elimination pass can write each finished row directly into the public key.
+#define ROW_BYTE(b) (((b) < PK_NROWS / 8) ? (b) + PK_ROW_BYTES : (b) - PK_NROWS / 8)
+
 /**
  * \brief Copies row stored inside accelerator to memory
  * \param row pointer to buffer to store row data
  */
 void ReadRow(uint32_t* row){
-    for (int i = 0; i < SINT; i++){
+    for (int i = 0; i < rowWords; i++){
         row[i] = VersatUnitRead(matAddr,i);
     }
 }
@@ -48,7 +71,39 @@ void ReadRow(uint32_t* row){
  * \param row pointer to buffer to load row data into accelerator
  */
 void VersatLoadRow(uint32_t* row){
-    VersatMemoryCopy(matAddr,CAST_PTR(int*,row),SINT * sizeof(int));
+    VersatMemoryCopy(matAddr,CAST_PTR(int*,row),rowWords * sizeof(int));
+}
+
+/**
+ * The full matrix rows and the rows of the systematic pre-check have different sizes.
+ * \brief Configures the accelerator units to process rows of the given size
+ * \param words size of each row in 32 bit words
+ */
+static void ConfigureRowSize(int words){
+    rowWords = words;
+
+    ConfigureSimpleVReadBare(&eliece->row);
+
+    eliece->mat.iterA = 1;
+    eliece->mat.incrA = 1;
+    eliece->mat.iterB = 1;
+    eliece->mat.incrB = 1;
+    eliece->mat.perA = words + 1;
+    eliece->mat.dutyA = words + 1;
+    eliece->mat.perB = words + 1;
+    eliece->mat.dutyB = words + 1;
+}
+
+/**
+ * Leaves the accelerator stopped and the McEliece units idle, so that they do not interfere with other algorithms
+ * \brief Finishes a sequence of McEliece runs
+ */
+static void McElieceEnd(){
+    EndAccelerator();
+
+    eliece->row.enableRead = 0;
+    eliece->writer.enableWrite = 0;
+    ShadowWrite(&eliece->mat.in0_wr,0);
 }
 
 /**
@@ -62,10 +117,10 @@ void VersatMcElieceLoop1(uint8_t *row, uint8_t mask,bool first){
     static uint8_t savedMask = 0;
     uint32_t *row_int = CAST_PTR(uint32_t*,row);
 
-    ConfigureSimpleVReadShallow(&vec->row, SINT, (int*) row_int);
+    ConfigureSimpleVReadShallow(&eliece->row, rowWords, (int*) row_int);
     if(first){
         // Disable writing to memory since in the first run the accelerator is filled with garbage data
-        vec->mat.in0_wr = 0;
+        ShadowWrite(&eliece->mat.in0_wr,0);
     } else {
         // The following runs enable memory write and configures the mask with the saved mask value.
         // The reason we have to use the savedMask is because the accelerator is one "run" ahead of the software.
@@ -74,8 +129,8 @@ void VersatMcElieceLoop1(uint8_t *row, uint8_t mask,bool first){
         // It is easier to store the mask and used it, it simplifies the outer code.
 
         uint32_t mask_int = (savedMask) | (savedMask << 8) | (savedMask << 8*2) | (savedMask << 8*3);
-        vec->mask.constant = mask_int;
-        vec->mat.in0_wr = 1;
+        ShadowWrite(&eliece->mask.constant,mask_int);
+        ShadowWrite(&eliece->mat.in0_wr,1);
     }
 
     // Ends the accelerator if still running
@@ -97,8 +152,9 @@ void VersatMcElieceLoop1(uint8_t *row, uint8_t mask,bool first){
  * \param k index of the row going to be processed next
  * \param row index of the row being processed
  * \param mask to apply during the operation
+ * \param pk if not NULL, the systematic part of each processed row is written to its place in the public key instead of back to mat
  */
-void VersatMcElieceLoop2(unsigned char** mat,int timesCalled,int k,int row,uint8_t mask){
+void VersatMcElieceLoop2(unsigned char** mat,int timesCalled,int k,int row,uint8_t mask,unsigned char* pk){
     static uint8_t savedMask = 0;
 
     // The accelerator contains VRead and VWrite units.
@@ -117,32 +173,37 @@ void VersatMcElieceLoop2(unsigned char** mat,int timesCalled,int k,int row,uint8
         // configure the VRead unit to read data
         int *toRead_int = CAST_PTR(int*,mat[toRead]);
 
-        vec->mat.in0_wr = 0;
+        ShadowWrite(&eliece->mat.in0_wr,0);
 
-        ConfigureSimpleVReadShallow(&vec->row, SINT,toRead_int);        
+        ConfigureSimpleVReadShallow(&eliece->row, rowWords,toRead_int);
     } else {
         // Otherwise disable it so we can save some cycles.
-        vec->row.enableRead = 0;
+        eliece->row.enableRead = 0;
     }
 
     // Same logic for toCompute
     if(timesCalled >= 1 && toCompute >= 0 && toCompute < PK_NROWS){
         uint32_t mask_int = (savedMask) | (savedMask << 8) | (savedMask << 8*2) | (savedMask << 8*3);
 
-        vec->mask.constant = mask_int;
+        ShadowWrite(&eliece->mask.constant,mask_int);
     } else {
         // Make sure that toWrite is disabled so that we do not write garbage data to memory in the first loop
-        ConfigureSimpleVWrite(&vec->writer, SINT, (int*) NULL);
-        vec->writer.enableWrite = 0;
+        ConfigureSimpleVWrite(&eliece->writer, rowWords, (int*) NULL);
+        eliece->writer.enableWrite = 0;
     }
     
     // And for toWrite
-    if(timesCalled >= 2 && toWrite >= 0){
+    if(timesCalled >= 2 && toWrite >= 0 && pk){
+        // The accelerator still produces the full row but only the first PK_ROW_BYTES, the systematic part, are written
+        int* toWrite_int = CAST_PTR(int*,pk + toWrite * PK_ROW_BYTES);
+        ConfigureSimpleVWrite(&eliece->writer, PK_ROW_BYTES / 4,toWrite_int);
+        eliece->writer.perB = rowWords;
+    } else if(timesCalled >= 2 && toWrite >= 0){
         int* toWrite_int = CAST_PTR(int*,mat[toWrite]);
-        ConfigureSimpleVWrite(&vec->writer, SINT,toWrite_int);
+        ConfigureSimpleVWrite(&eliece->writer, rowWords,toWrite_int);
     } else {
         // Need to disable write otherwise we write garbage data to memory
-        vec->writer.enableWrite = 0;
+        eliece->writer.enableWrite = 0;
     }
 
     // Ends the accelerator if still running
@@ -169,43 +230,296 @@ static crypto_uint64 uint64_is_zero_declassify(uint64_t t) {
 }
 
 
+/**
+ * The columns are processed 64 at a time. Once the 64 field elements are packed into bit planes, plane k is exactly
+ * the 64 bits of row i * GFBITS + k for these columns, so each row is written with a single store instead of gathering one bit per element.
+ * \brief Fills a range of columns of the matrix
+ * \param mat the matrix as an array of rows
+ * \param roots the Goppa polynomial evaluated over the support
+ * \param L the support
+ * \param firstColumn first column to fill, multiple of 64
+ * \param lastColumn one past the last column to fill
+ * \param rotated true if rows are stored rotated (see ROW_BYTE), false if column 0 is at the start of the row
+ */
+static void FillMatrixColumns(unsigned char** mat,gf* roots,gf* L,int firstColumn,int lastColumn,bool rotated){
+    int i, j, k, c;
+
+    for (j = firstColumn; j < lastColumn; j += 64) {
+        int n = (lastColumn - j < 64) ? lastColumn - j : 64;
+        int offset = rotated ? ROW_BYTE(j / 8) : (j - firstColumn) / 8;
+
+        // When PK_NROWS is not a multiple of 64, the block that contains column PK_NROWS wraps around the end of a rotated row
+        bool wraps = rotated && j < PK_NROWS && j + n > PK_NROWS;
+        uint64_t planes[ GFBITS ];
+        uint64_t elems[ GFBITS ];
+        uint64_t support[ GFBITS ];
+
+        vec_pack(elems, roots + j, n);
+        vec_inv(planes, elems);
+        vec_pack(support, L + j, n);
+
+        for (i = 0; i < SYS_T; i++) {
+            for (k = 0; k < GFBITS; k++) {
+                unsigned char* dst = &mat[ i * GFBITS + k ][ offset ];
+
+                if (wraps) {
+                    for (c = 0; c < n / 8; c++) {
+                        mat[ i * GFBITS + k ][ ROW_BYTE(j / 8 + c) ] = (planes[k] >> (8 * c)) & 0xFF;
+                    }
+                } else if (n == 64) {
+                    store8(dst, planes[k]);
+                } else {
+                    for (c = 0; c < n / 8; c++) {
+                        dst[c] = (planes[k] >> (8 * c)) & 0xFF;
+                    }
+                }
+            }
+
+            vec_mul(planes, planes, support);
+        }
+    }
+}
+
+/**
+ * The matrix is systematic if and only if its first PK_NROWS columns are linearly independent.
+ * This function brings a compact copy of those columns (PK_NROWS / 8 bytes per row) into row echelon form using the accelerator.
+ * Only the rows below each pivot are eliminated, which together with the smaller rows makes this much cheaper than the full elimination.
+ * Like the full elimination, it returns at the first missing pivot and otherwise only uses masked operations.
+ * \brief Checks if the matrix can be put into systematic form
+ * \param mat the compact matrix as an array of rows. It is destroyed
+ * \return 0 if systematic, -1 otherwise
+ */
+static int VersatCheckSystematic(unsigned char** mat){
+    int i, j, k;
+    int row;
+    unsigned char mask;
+
+    ConfigureRowSize(PK_NROWS / 32);
+
+    for (i = 0; i < (PK_NROWS + 7) / 8; i++) {
+        for (j = 0; j < 8; j++) {
+            row = i * 8 + j;
+
+            if (row >= PK_NROWS) {
+                break;
+            }
+
+            uint32_t *out_int = CAST_PTR(uint32_t*,mat[row]);
+            EndAccelerator();
+
+            VersatLoadRow(out_int);
+            bool first = true;
+            for (k = row + 1; k < PK_NROWS; k++) {
+                mask = mat[ row ][ i ] ^ mat[ k ][ i ];
+                mask >>= j;
+                mask &= 1;
+                mask = -mask;
+
+                VersatMcElieceLoop1(mat[k],mask,first);
+
+                mat[row][i] ^= mat[k][i] & mask;
+                first = false;
+            }
+
+            VersatMcElieceLoop1(mat[PK_NROWS - 1],0,false);
+
+            EndAccelerator();
+
+            if ( uint64_is_zero_declassify((mat[ row ][ i ] >> j) & 1) ) {
+                McElieceEnd();
+                return -1;
+            }
+
+            if (row == PK_NROWS - 1) {
+                break;
+            }
+
+            ReadRow(out_int);
+
+            int index = 0;
+            for (k = row + 1; k < PK_NROWS; k++) {
+                mask = mat[k][i] >> j;
+                mask &= 1;
+                mask = -mask;
+
+                VersatMcElieceLoop2(mat,index,k,row,mask,NULL);
+                index += 1;
+            }
+
+            VersatMcElieceLoop2(mat,index++,PK_NROWS,row,0,NULL);
+            VersatMcElieceLoop2(mat,index++,PK_NROWS + 1,row,0,NULL);
+            eliece->writer.enableWrite = 0;
+        }
+    }
+
+    McElieceEnd();
+
+    return 0;
+}
+
+/* return number of trailing zeros of the non-zero input in */
+static inline int ctz(uint64_t in) {
+    int i, b, m = 0, r = 0;
+
+    for (i = 0; i < 64; i++) {
+        b = (int)(in >> i) & 1;
+        m |= b;
+        r += (m ^ 1) & (b ^ 1);
+    }
+
+    return r;
+}
+
+static inline uint64_t same_mask(uint16_t x, uint16_t y) {
+    uint64_t mask;
+
+    mask = x ^ y;
+    mask -= 1;
+    mask >>= 63;
+    mask = -mask;
+
+    return mask;
+}
+
+/**
+ * \brief Loads 64 consecutive columns of a rotated row (they can wrap around the end of the row)
+ * \param row the matrix row
+ * \param byte index of the first column divided by 8, as if the row was not rotated
+ * \return the 64 columns, first column in the least significant bit
+ */
+static uint64_t LoadColumns(unsigned char* row,int byte){
+    unsigned char tmp[8];
+
+    for (int c = 0; c < 8; c++) {
+        tmp[c] = row[ROW_BYTE(byte + c)];
+    }
+
+    return load8(tmp);
+}
+
+/**
+ * \brief Stores 64 consecutive columns of a rotated row. Inverse of LoadColumns
+ * \param row the matrix row
+ * \param byte index of the first column divided by 8, as if the row was not rotated
+ * \param value the 64 columns, first column in the least significant bit
+ */
+static void StoreColumns(unsigned char* row,int byte,uint64_t value){
+    unsigned char tmp[8];
+
+    store8(tmp, value);
+
+    for (int c = 0; c < 8; c++) {
+        row[ROW_BYTE(byte + c)] = tmp[c];
+    }
+}
+
+/**
+ * Taken from the semi-systematic (f) variant of PQClean, adapted to the rotated rows.
+ * Called when the elimination reaches row PK_NROWS - 32. Looks for 32 pivots among the next 64 columns and
+ * swaps them into place, updating the permutation pi accordingly.
+ * \brief Moves pivot columns into place for semi-systematic form
+ * \param mat the matrix as an array of rows
+ * \param pi the permutation, updated with the column swaps
+ * \param pivots receives a bit mask with the positions of the pivots
+ * \return 0 on success, -1 if the 64 columns do not contain 32 pivots
+ */
+static int mov_columns(unsigned char** mat, int16_t *pi, uint64_t *pivots) {
+    int i, j, k, s, block_idx, row;
+    uint64_t buf[64], ctz_list[32], t, d, mask, one = 1;
+
+    row = PK_NROWS - 32;
+    block_idx = row / 8;
+
+    // extract the 32x64 matrix
+
+    for (i = 0; i < 32; i++) {
+        buf[i] = LoadColumns(mat[ row + i ], block_idx);
+    }
+
+    // compute the column indices of pivots by Gaussian elimination.
+    // the indices are stored in ctz_list
+
+    *pivots = 0;
+
+    for (i = 0; i < 32; i++) {
+        t = buf[i];
+        for (j = i + 1; j < 32; j++) {
+            t |= buf[j];
+        }
+
+        if (uint64_is_zero_declassify(t)) {
+            return -1;    // return if buf is not full rank
+        }
+
+        ctz_list[i] = s = ctz(t);
+        *pivots |= one << ctz_list[i];
+
+        for (j = i + 1; j < 32; j++) {
+            mask = (buf[i] >> s) & 1;
+            mask -= 1;
+            buf[i] ^= buf[j] & mask;
+        }
+        for (j = i + 1; j < 32; j++) {
+            mask = (buf[j] >> s) & 1;
+            mask = -mask;
+            buf[j] ^= buf[i] & mask;
+        }
+    }
+
+    // updating permutation
+
+    for (j = 0;   j < 32; j++) {
+        for (k = j + 1; k < 64; k++) {
+            d = pi[ row + j ] ^ pi[ row + k ];
+            d &= same_mask(k, ctz_list[j]);
+            pi[ row + j ] ^= d;
+            pi[ row + k ] ^= d;
+        }
+    }
+
+    // moving columns of mat according to the column indices of pivots
+
+    for (i = 0; i < PK_NROWS; i++) {
+        t = LoadColumns(mat[ i ], block_idx);
+
+        for (j = 0; j < 32; j++) {
+            d  = t >> j;
+            d ^= t >> ctz_list[j];
+            d &= 1;
+
+            t ^= d << ctz_list[j];
+            t ^= d << j;
+        }
+
+        StoreColumns(mat[ i ], block_idx, t);
+    }
+
+    return 0;
+}
+
 /**
  * This function was taken from PQClean. Only a small portion of this function was altered to implement acceleration and to make it work in an embedded system. 
  * \brief Versat implementation of the pk_gen function.
+ * \param pivots NULL for the systematic variant. Otherwise the semi-systematic (f) variant is used and this receives the pivot positions
  */
-int Versat_pk_gen(unsigned char *pk, unsigned char *sk, const uint32_t *perm, int16_t *pi) {
+int Versat_pk_gen(unsigned char *pk, unsigned char *sk, const uint32_t *perm, int16_t *pi, uint64_t *pivots) {
     int i, j, k;
-    int row, c;
+    int row;
 
     unsigned char mask;
-    unsigned char b;
 
     int mark = MarkArena(globalArena);
 
+    VersatJobWaitAll();
+
     // Init needed values for versat later on.  
     CryptoAlgosConfig* topConfig = (CryptoAlgosConfig*) accelConfig;
-    vec = (McElieceConfig*) &topConfig->eliece;
+    eliece = (McElieceConfig*) &topConfig->eliece;
     matAddr = (void*) TOP_eliece_mat_addr;
 
-    // Both the VRead and the memories process the same amount of data everytime
-    // Might as well configure this part upfront, since it never changes.
-    ConfigureSimpleVReadBare(&vec->row);
-
-    vec->mat.iterA = 1;
-    vec->mat.incrA = 1;
-    vec->mat.iterB = 1;
-    vec->mat.incrB = 1;
-    vec->mat.perA = SINT + 1;
-    vec->mat.dutyA = SINT + 1;
-    vec->mat.perB = SINT + 1;
-    vec->mat.dutyB = SINT + 1;
-
-    uint64_t buf[ 1 << GFBITS ];
+    uint64_t* buf = PushArray(globalArena,1 << GFBITS,uint64_t);
 
     unsigned char** mat = PushArray(globalArena,PK_NROWS,unsigned char*);
-    for(int i = 0; i < PK_NROWS; i++){
-        mat[i] = PushArray(globalArena,SYS_N / 8,unsigned char); // This guarantees that each row is properly aligned to a 32 bit boundary.
-    }
 
     gf* g = PushArray(globalArena,SYS_T + 1,gf);
     gf* L = PushArray(globalArena,SYS_N,gf); // support
@@ -224,15 +538,20 @@ int Versat_pk_gen(unsigned char *pk, unsigned char *sk, const uint32_t *perm, in
         buf[i] |= i;
     }
 
-    uint64_sort(buf, 1 << GFBITS);
+    PROFILE_BEGIN(sort);
+
+    VersatSortU64(buf, 1 << GFBITS);
 
     for (i = 1; i < (1 << GFBITS); i++) {
         if (uint64_is_equal_declassify(buf[i - 1] >> 31, buf[i] >> 31)) {
+            PROFILE_END(sort);
             PopArena(globalArena,mark);
             return -1;
         }
     }
 
+    PROFILE_END(sort);
+
     for (i = 0; i < (1 << GFBITS); i++) {
         pi[i] = buf[i] & GFMASK;
     }
@@ -240,51 +559,55 @@ int Versat_pk_gen(unsigned char *pk, unsigned char *sk, const uint32_t *perm, in
         L[i] = bitrev(pi[i]);
     }
 
-    // filling the matrix
-
     root(inv, g, L);
 
-    for (i = 0; i < SYS_N; i++) {
-        inv[i] = gf_inv(inv[i]);
-    }
+    // Most attempts do not produce a systematic matrix. Checking the first PK_NROWS columns on their own
+    // rejects those attempts before paying for the full matrix fill and elimination.
+    // A failing attempt usually finds the missing pivot near the end, so the check makes about as many runs as the elimination
+    // it replaces, but each of them streams PK_NROWS / 32 words instead of SINT. Its echelon form is not reused on success:
+    // the full rows still need every row operation, and only the pivot checks of the elimination become redundant.
+    // The compact matrix is built at the start of the pk buffer, which is overwritten by the full matrix afterwards.
+    // The semi-systematic variant almost never fails and does not need the first PK_NROWS columns to be independent.
+    if (!pivots) {
+        PROFILE_BEGIN(systematicCheck);
+
+        for(i = 0; i < PK_NROWS; i++){
+            mat[i] = pk + i * (PK_NROWS / 8);
+        }
 
-    for (i = 0; i < PK_NROWS; i++) {
-        for (j = 0; j < SYS_N / 8; j++) {
-            mat[i][j] = 0;
+        FillMatrixColumns(mat, inv, L, 0, PK_NROWS, false);
+
+        int systematic = VersatCheckSystematic(mat);
+
+        PROFILE_END(systematicCheck);
+
+        if (systematic != 0) {
+            PopArena(globalArena,mark);
+            return -1;
         }
     }
 
-    for (i = 0; i < SYS_T; i++) {
-        for (j = 0; j < SYS_N; j += 8) {
-            for (k = 0; k < GFBITS;  k++) {
-                b  = (inv[j + 7] >> k) & 1;
-                b <<= 1;
-                b |= (inv[j + 6] >> k) & 1;
-                b <<= 1;
-                b |= (inv[j + 5] >> k) & 1;
-                b <<= 1;
-                b |= (inv[j + 4] >> k) & 1;
-                b <<= 1;
-                b |= (inv[j + 3] >> k) & 1;
-                b <<= 1;
-                b |= (inv[j + 2] >> k) & 1;
-                b <<= 1;
-                b |= (inv[j + 1] >> k) & 1;
-                b <<= 1;
-                b |= (inv[j + 0] >> k) & 1;
-
-                mat[ i * GFBITS + k ][ j / 8 ] = b;
-            }
-        }
+    // filling the matrix
 
-        for (j = 0; j < SYS_N; j++) {
-            inv[j] = gf_mul(inv[j], L[j]);
-        }
+    PROFILE_BEGIN(matrixFill);
+
+    // The matrix lives inside the caller's pk buffer (see VERSAT_MCELIECE_PK_BUFFER_SIZE).
+    // Rows are VERSAT_MCELIECE_ROW_STRIDE bytes apart, a multiple of 64, so they start on the same boundary as pk.
+    for(i = 0; i < PK_NROWS; i++){
+        mat[i] = pk + i * VERSAT_MCELIECE_ROW_STRIDE;
     }
 
+    FillMatrixColumns(mat, inv, L, 0, SYS_N, true);
+
+    PROFILE_END(matrixFill);
+
     // This is the portion of the code that is accelerator with Versat.
     // This part basically performs gaussian elimination with a big bit matrix.
     // Elimination is performed using the XOR operation
+    PROFILE_BEGIN(elimination);
+
+    ConfigureRowSize(SINT);
+
     for (i = 0; i < (PK_NROWS + 7) / 8; i++) {
         for (j = 0; j < 8; j++) {
             row = i * 8 + j;
@@ -296,11 +619,20 @@ int Versat_pk_gen(unsigned char *pk, unsigned char *sk, const uint32_t *perm, in
             uint32_t *out_int = CAST_PTR(uint32_t*,mat[row]);
             EndAccelerator(); // Make sure accelerator is not running
 
+            // Every row in memory is up to date here, so the CPU can swap columns before the last 32 pivots
+            if (pivots && row == PK_NROWS - 32) {
+                if (mov_columns(mat, pi, pivots)) {
+                    PROFILE_END(elimination);
+                    PopArena(globalArena,mark);
+                    return -1;
+                }
+            }
+
             // Store row to be processed inside accelerator memory
             VersatLoadRow(out_int);
             bool first = true;
             for (k = row + 1; k < PK_NROWS; k++) {
-                mask = mat[ row ][ i ] ^ mat[ k ][ i ];
+                mask = mat[ row ][ ROW_BYTE(i) ] ^ mat[ k ][ ROW_BYTE(i) ];
                 mask >>= j;
                 mask &= 1;
                 mask = -mask;
@@ -308,7 +640,7 @@ int Versat_pk_gen(unsigned char *pk, unsigned char *sk, const uint32_t *perm, in
                 VersatMcElieceLoop1(mat[k],mask,first); // Process all the following rows to change the value of the accelerator internal memory (which contains a copy of mat[row])
 
                 // We could fetch this value from the accelerator Versat, but it's easier to calculate it since it is only one.
-                mat[row][i] ^= mat[k][i] & mask;
+                mat[row][ROW_BYTE(i)] ^= mat[k][ROW_BYTE(i)] & mask;
                 first = false;
             }
 
@@ -317,47 +649,62 @@ int Versat_pk_gen(unsigned char *pk, unsigned char *sk, const uint32_t *perm, in
 
             EndAccelerator();
 
-            if ( uint64_is_zero_declassify((mat[ row ][ i ] >> j) & 1) ) { // return if not systematic
+            if ( uint64_is_zero_declassify((mat[ row ][ ROW_BYTE(i) ] >> j) & 1) ) { // return if not systematic
+               McElieceEnd();
+               PROFILE_END(elimination);
                PopArena(globalArena,mark);
                return -1;
             }
 
             ReadRow(out_int); // Read value from memory. mat[row] is now good
 
+            // After the last pivot every row is final, so the accelerator writes them straight into the public key.
+            // Rows are written in increasing order and public key row k only overlaps matrix rows 0 to k,
+            // which have all been read by the time row k is written.
+            unsigned char* dst = (row == PK_NROWS - 1) ? pk : NULL;
+
             int index = 0;
             for (k = 0; k < PK_NROWS; k++) {
                 if (k != row) {
-                    mask = mat[k][i] >> j;
+                    mask = mat[k][ROW_BYTE(i)] >> j;
                     mask &= 1;
                     mask = -mask;
 
-                    VersatMcElieceLoop2(mat,index,k,row,mask); // Change the other rows based on the value of the accelerator internal memory (which contains a copy of mat[row])
+                    VersatMcElieceLoop2(mat,index,k,row,mask,dst); // Change the other rows based on the value of the accelerator internal memory (which contains a copy of mat[row])
                     index += 1;
                 }
             }
 
             // Need to flush two times. One to flush the valid data stored inside the accelerator and the second
             // so that the VWrite unit writes the data processed in the last run to memory.
-            VersatMcElieceLoop2(mat,index++,PK_NROWS,row,0);
-            VersatMcElieceLoop2(mat,index++,PK_NROWS + 1,row,0);
-            vec->writer.enableWrite = 0;
+            VersatMcElieceLoop2(mat,index++,PK_NROWS,row,0,dst);
+            VersatMcElieceLoop2(mat,index++,PK_NROWS + 1,row,0,dst);
+            eliece->writer.enableWrite = 0;
         }
     }
 
-    for (i = 0; i < PK_NROWS; i++) {
-        memcpy(pk + i * PK_ROW_BYTES, mat[i] + PK_NROWS / 8, PK_ROW_BYTES);
-    }
+    // The last flush run is still writing a public key row
+    McElieceEnd();
+
+    PROFILE_END(elimination);
+
+    // The pivot row of the last pass never goes through the VWrite unit
+    memcpy(pk + (PK_NROWS - 1) * PK_ROW_BYTES, mat[PK_NROWS - 1], PK_ROW_BYTES);
 
     PopArena(globalArena,mark);
     return 0;
 }
 
-void VersatMcEliece
-(
-    unsigned char *pk,
-    unsigned char *sk
-) {
+/**
+ * Key generation loop shared by the systematic and semi-systematic variants. Taken from PQClean crypto_kem_keypair.
+ * \brief Generates a McEliece key pair
+ * \param pk public key buffer, see VERSAT_MCELIECE_PK_BUFFER_SIZE
+ * \param sk secret key buffer
+ * \param semiSystematic true to generate keys for the semi-systematic (f) variant
+ */
+static void McElieceKeypair(unsigned char *pk,unsigned char *sk,bool semiSystematic){
     int i;
+    uint64_t pivots;
     unsigned char seed[ 33 ] = {64};
     unsigned char *rp, *skp;
 
@@ -367,6 +714,10 @@ void VersatMcEliece
 
     int mark = MarkArena(globalArena);
 
+#ifdef MCELIECE_BENCHMARK
+    profile = (McElieceProfile){0};
+#endif
+
     unsigned char* r = PushAndZeroArray(globalArena,sizeofR,unsigned char);
 
     gf* f = PushAndZeroArray(globalArena,SYS_T,gf);
@@ -380,7 +731,14 @@ void VersatMcEliece
         rp = &r[ sizeofR - 32 ];
         skp = sk;
 
+#ifdef MCELIECE_BENCHMARK
+        profile.attempts += 1;
+#endif
+
+        PROFILE_BEGIN(seedExpansion);
         shake(r, sizeofR, seed, 33);
+        PROFILE_END(seedExpansion);
+
         memcpy(skp, seed + 1, 32);
         skp += 32 + 8;
         memcpy(seed + 1, &r[ sizeofR - 32 ], 32);
@@ -391,7 +749,11 @@ void VersatMcEliece
             f[i] = load_gf(rp + i * 2);
         }
 
-        if (genpoly_gen(irr, f)) {
+        PROFILE_BEGIN(genpoly);
+        int genpolyFailed = genpoly_gen(irr, f);
+        PROFILE_END(genpoly);
+
+        if (genpolyFailed) {
             continue;
         }
 
@@ -409,20 +771,37 @@ void VersatMcEliece
 
         // Everything else is mostly the same, with some code changes required to run this in an embedded system
         // The only change is this function here that implements a loop accelerated by Versat
-        if (Versat_pk_gen(pk, skp - IRR_BYTES, perm, pi)) {
+        if (Versat_pk_gen(pk, skp - IRR_BYTES, perm, pi, semiSystematic ? &pivots : NULL)) {
             continue;
         }
 
+        PROFILE_BEGIN(controlBits);
         controlbitsfrompermutation(skp, pi, GFBITS, 1 << GFBITS);
+        PROFILE_END(controlBits);
         skp += COND_BYTES;
 
         rp -= SYS_N / 8;
         memcpy(skp, rp, SYS_N / 8);
 
-        store8(sk + 32, 0xFFFFFFFF);
+        // storing positions of the 32 pivots
+        store8(sk + 32, semiSystematic ? pivots : 0xFFFFFFFF);
 
         break;
     }
 
     PopArena(globalArena,mark);
 }
+
+void VersatMcEliece(unsigned char *pk,unsigned char *sk){
+    McElieceKeypair(pk,sk,false);
+}
+
+void VersatMcElieceSemiSystematic(unsigned char *pk,unsigned char *sk){
+    McElieceKeypair(pk,sk,true);
+}
+
+#ifdef MCELIECE_BENCHMARK
+McElieceProfile GetMcElieceProfile(){
+    return profile;
+}
+#endif
@@ -0,0 +1,171 @@
+#include "versat_crypto.h"
+
+#include "versat_accel.h"
+#include "versat_shadow.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "unitConfiguration.h"
+
+#include "arena.h"
+
+// Prevents "cast increases required alignment" warnings by gcc
+#define CAST_PTR(TYPE,PTR) ((TYPE) ((void*) (PTR)))
+
+// Points and values are streamed as words of two field elements, at most BLOCK_WORDS per run
+#define BLOCK_WORDS 64
+#define POINT_WORDS (SYS_N / 2)
+
+// The SYS_T + 1 coefficients padded with a zero
+#define COEF_WORDS ((SYS_T + 2) / 2)
+
+static RootConfig* roots = NULL;
+
+// VRead needs 32 bit aligned addresses
+static uint32_t coefBuffer[COEF_WORDS];
+
+/**
+ * Only the pointer to the configuration needs to be set. With the unit disabled it stays idle while other algorithms use the accelerator.
+ * \brief Initializes Versat Root
+ */
+static void InitVersatRoot(){
+   CryptoAlgosConfig* config = (CryptoAlgosConfig*) accelConfig;
+   roots = &config->roots;
+
+   ConfigureSimpleVReadBare(&roots->points);
+   ConfigureSimpleVWriteBare(&roots->values);
+
+   ShadowWrite(&roots->horner.enable,0);
+   ShadowWrite(&roots->horner.loadCoefs,0);
+   ShadowWrite(&roots->horner.evaluate,0);
+   ShadowWrite(&roots->horner.words,0);
+   roots->horner.degree = SYS_T;
+   roots->horner.gf13 = (GFBITS == 13);
+}
+
+static bool IsAligned(const void* ptr){
+   return (((iptr) ptr) & 3) == 0;
+}
+
+/**
+ * Like the other units, the accelerator is one run ahead of the software. Data fetched by the VRead in a run only reaches the
+ * HornerEval unit in the next run, and the values streamed to the VWrite in a run are only written to memory in the next run.
+ * \brief Configures and starts one accelerator run
+ * \param fetch memory the VRead starts fetching, NULL to disable it
+ * \param fetchWords amount of words to fetch
+ * \param load replace the coefficients with the words fetched in the previous run
+ * \param evaluate evaluate the polynomial at the points fetched in the previous run
+ * \param words words received and streamed out by the unit, 0 to leave it idle
+ * \param write memory where the values streamed in the previous run are written, NULL to disable it
+ * \param writeWords amount of words to write
+ */
+static void RootRun(const void* fetch,int fetchWords,bool load,bool evaluate,int words,void* write,int writeWords){
+   if(fetch){
+      ConfigureSimpleVReadShallow(&roots->points,fetchWords,(int*) fetch);
+   } else {
+      roots->points.enableRead = 0;
+   }
+
+   // The unit receives the words fetched in the previous run, the coefficients are more than the points fetched with them
+   if(words > 0){
+      roots->points.perB = words;
+      roots->points.dutyB = words;
+   }
+
+   ShadowWrite(&roots->horner.enable,(words > 0));
+   ShadowWrite(&roots->horner.loadCoefs,load);
+   ShadowWrite(&roots->horner.evaluate,evaluate);
+   ShadowWrite(&roots->horner.words,words);
+
+   // The unit streams words values but only the ones of the previous block are written
+   ConfigureSimpleVWriteShallow(&roots->values,writeWords,(int*) write);
+   roots->values.perB = words;
+   if(!write){
+      roots->values.enableWrite = 0;
+   }
+
+   EndAccelerator();
+   StartAccelerator();
+}
+
+// Only the first block can be smaller than BLOCK_WORDS. The values of a block are streamed by the run that receives
+// the next block, which is always full, so the VWrite receives them all and only writes the ones that belong to the block.
+static int BlockStart(int block,int first){
+   return (block == 0) ? 0 : first + (block - 1) * BLOCK_WORDS;
+}
+
+static int BlockSize(int block,int first){
+   return (block == 0) ? first : BLOCK_WORDS;
+}
+
+void VersatRoot(uint16_t* out,const uint16_t* f,const uint16_t* L){
+   VersatJobWaitAll();
+
+   if(!roots){
+      InitVersatRoot();
+   }
+
+   int mark = MarkArena(globalArena);
+
+   const uint32_t* points = CAST_PTR(const uint32_t*,L);
+   if(!IsAligned(L)){
+      uint32_t* copy = PushArray(globalArena,POINT_WORDS,uint32_t);
+      memcpy(copy,L,SYS_N * sizeof(uint16_t));
+      points = copy;
+   }
+
+   uint32_t* values = CAST_PTR(uint32_t*,out);
+   if(!IsAligned(out)){
+      values = PushArray(globalArena,POINT_WORDS,uint32_t);
+   }
+
+   uint16_t* coefs = CAST_PTR(uint16_t*,coefBuffer);
+   memcpy(coefs,f,(SYS_T + 1) * sizeof(uint16_t));
+   coefs[SYS_T + 1] = 0;
+
+   int blocks = (POINT_WORDS + BLOCK_WORDS - 1) / BLOCK_WORDS;
+   int first = POINT_WORDS - (blocks - 1) * BLOCK_WORDS;
+
+   RootRun(coefBuffer,COEF_WORDS,false,false,0,NULL,0);                         // Fetch coefficients
+   RootRun(points,BlockSize(0,first),true,false,COEF_WORDS,NULL,0);             // Load them and fetch the first block
+
+   for(int block = 0; block < blocks; block++){
+      // Evaluate a block while the next one is fetched and the values of the one before the previous are written
+      const uint32_t* fetch = NULL;
+      int fetchWords = 0;
+      if(block + 1 < blocks){
+         fetch = points + BlockStart(block + 1,first);
+         fetchWords = BlockSize(block + 1,first);
+      }
+
+      uint32_t* write = NULL;
+      int writeWords = 0;
+      if(block >= 2){
+         write = values + BlockStart(block - 2,first);
+         writeWords = BlockSize(block - 2,first);
+      }
+
+      RootRun(fetch,fetchWords,false,true,BlockSize(block,first),write,writeWords);
+   }
+
+   // Stream the values of the last block, then write them
+   if(blocks >= 2){
+      RootRun(NULL,0,false,false,BLOCK_WORDS,values + BlockStart(blocks - 2,first),BlockSize(blocks - 2,first));
+   } else {
+      RootRun(NULL,0,false,false,BLOCK_WORDS,NULL,0);
+   }
+   RootRun(NULL,0,false,false,BLOCK_WORDS,values + BlockStart(blocks - 1,first),BlockSize(blocks - 1,first));
+
+   EndAccelerator();
+
+   roots->points.enableRead = 0;
+   roots->values.enableWrite = 0;
+   ShadowWrite(&roots->horner.enable,0);
+
+   if(values != CAST_PTR(uint32_t*,out)){
+      memcpy(out,values,SYS_N * sizeof(uint16_t));
+   }
+
+   PopArena(globalArena,mark);
+}
@@ -0,0 +1,65 @@
+#include "versat_sequence.h"
+
+#include "versat_shadow.h"
+
+#include "printf.h"
+
+void SequenceInit(ConfigSequence* seq,ConfigStep* steps,int maxSteps,ConfigDelta* deltas,int maxDeltas){
+   seq->steps = steps;
+   seq->numberSteps = 0;
+   seq->maxSteps = maxSteps;
+   seq->deltas = deltas;
+   seq->numberDeltas = 0;
+   seq->maxDeltas = maxDeltas;
+}
+
+void SequenceStep(ConfigSequence* seq,int merge){
+   if(seq->numberSteps >= seq->maxSteps){
+      printf("Configuration sequence has more than %d steps\n",seq->maxSteps);
+      return;
+   }
+
+   ConfigStep* step = &seq->steps[seq->numberSteps++];
+   step->merge = merge;
+   step->firstDelta = seq->numberDeltas;
+   step->deltas = 0;
+}
+
+void SequenceSet(ConfigSequence* seq,iptr* field,iptr value){
+   if(seq->numberSteps == 0 || seq->numberDeltas >= seq->maxDeltas){
+      printf("Configuration sequence has more than %d deltas\n",seq->maxDeltas);
+      return;
+   }
+
+   ConfigDelta* delta = &seq->deltas[seq->numberDeltas++];
+   delta->word = (uint16_t) (field - (iptr*) accelConfig);
+   delta->value = value;
+
+   seq->steps[seq->numberSteps - 1].deltas += 1;
+}
+
+void SequenceApplyStep(const ConfigSequence* seq,int step){
+   const ConfigStep* s = &seq->steps[step];
+
+   if(s->merge >= 0){
+      ActivateMergedAccelerator(s->merge);
+
+      // The merge switch writes configuration words directly, and which ones is decided by the generated code
+      ShadowInvalidate();
+   }
+
+   iptr* config = (iptr*) accelConfig;
+   const ConfigDelta* delta = &seq->deltas[s->firstDelta];
+   for(int i = 0; i < s->deltas; i++){
+      ShadowWrite(&config[delta[i].word],delta[i].value);
+   }
+}
+
+void SequenceRunSteps(const ConfigSequence* seq,int first,int count){
+   for(int i = first; i < first + count; i++){
+      SequenceApplyStep(seq,i);
+
+      EndAccelerator();
+      StartAccelerator();
+   }
+}
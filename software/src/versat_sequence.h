@@ -0,0 +1,86 @@
+#ifndef INCLUDED_VERSAT_SEQUENCE
+#define INCLUDED_VERSAT_SEQUENCE
+
+#include "stdint.h"
+
+#include "versat_accel.h"
+
+/** \file
+ * Describes a fixed program of accelerator runs as a table of configuration changes, built once and replayed for every use.
+ * The AES rounds and key expansion change the same few fields before each run in an order that never depends on the data,
+ * so replaying a table replaces the code that computes every value before every run.
+ * Values are written with ShadowWrite, so a step only writes the fields that differ from the previous run.
+ */
+
+//! Writes value to a word of the configuration
+typedef struct{
+  //! Index of the word inside accelConfig, in units of iptr
+  uint16_t word;
+  //! Value written
+  iptr value;
+} ConfigDelta;
+
+//! Configuration changes made before one accelerator run
+typedef struct{
+  //! Merge type activated by ActivateMergedAccelerator before the run, -1 to keep the current one
+  int merge;
+  //! Index of the first delta of the step
+  int firstDelta;
+  //! Number of deltas of the step
+  int deltas;
+} ConfigStep;
+
+//! A table of steps, one for each accelerator run. The memory of the tables belongs to the caller
+typedef struct{
+  ConfigStep* steps;
+  int numberSteps;
+  int maxSteps;
+  ConfigDelta* deltas;
+  int numberDeltas;
+  int maxDeltas;
+} ConfigSequence;
+
+/**
+ * \brief Starts building an empty sequence
+ * \param seq the sequence
+ * \param steps memory for maxSteps steps
+ * \param maxSteps capacity of steps
+ * \param deltas memory for maxDeltas deltas
+ * \param maxDeltas capacity of deltas
+ */
+void SequenceInit(ConfigSequence* seq,ConfigStep* steps,int maxSteps,ConfigDelta* deltas,int maxDeltas);
+
+/**
+ * \brief Appends a step, the following calls to SequenceSet add deltas to it
+ * \param seq the sequence
+ * \param merge merge type activated before the run, -1 to keep the current one
+ */
+void SequenceStep(ConfigSequence* seq,int merge);
+
+/**
+ * \brief Adds a delta to the last step
+ * \param seq the sequence
+ * \param field pointer to the field inside accelConfig
+ * \param value value written to the field before the run
+ */
+void SequenceSet(ConfigSequence* seq,iptr* field,iptr value);
+
+/**
+ * Does not start the accelerator, so that the caller can add its own changes before the run
+ * \brief Applies the configuration changes of one step
+ * \param seq the sequence
+ * \param step index of the step
+ */
+void SequenceApplyStep(const ConfigSequence* seq,int step);
+
+/**
+ * For each step, applies it and starts the accelerator once the previous run completed.
+ * The last run is left running, like the drivers leave the runs they start.
+ * \brief Runs consecutive steps of a sequence
+ * \param seq the sequence
+ * \param first index of the first step
+ * \param count number of steps
+ */
+void SequenceRunSteps(const ConfigSequence* seq,int first,int count);
+
+#endif // INCLUDED_VERSAT_SEQUENCE
@@ -17,9 +17,6 @@ static uint32_t kConstants3[] = {0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x3
 
 static uint32_t* kConstants[4] = {kConstants0,kConstants1,kConstants2,kConstants3};
 
-// GLOBALS
-static bool runInitialized = false; // The first accelerator run loads the data, only the next runs actual process valid data. Need to keep track of when the "actual" run starts
-
 static void store_bigendian_32(uint8_t *x, uint32_t u) {
    x[3] = (uint8_t) u;
    u >>= 8;
@@ -66,88 +63,66 @@ void InitVersatSHA(){
    ACCEL_TOP_sha_Swap_enabled = 1;
 }
 
-static size_t versat_crypto_hashblocks_sha256(const uint8_t *in, size_t inlen) {
-   while (inlen >= 64) {
-      ACCEL_TOP_sha_MemRead_ext_addr = (iptr) in; // Need to change input source every run
-   
-      // Loads data + performs work
-      RunAccelerator(1);
-
-      if(!runInitialized){
-         runInitialized = true;
-
-         // Only load state after doing the first run, since the first run is the one that loads valid data and only the following runs do the actual work.
-         // This means that the result of the first run is garbage and we only want to set the initial valid state when we gonna process actual valid data.
-         VersatUnitWrite(TOP_sha_State_s_0_reg_addr,0,initialStateValues[0]);
-         VersatUnitWrite(TOP_sha_State_s_1_reg_addr,0,initialStateValues[1]);
-         VersatUnitWrite(TOP_sha_State_s_2_reg_addr,0,initialStateValues[2]);
-         VersatUnitWrite(TOP_sha_State_s_3_reg_addr,0,initialStateValues[3]);
-         VersatUnitWrite(TOP_sha_State_s_4_reg_addr,0,initialStateValues[4]);
-         VersatUnitWrite(TOP_sha_State_s_5_reg_addr,0,initialStateValues[5]);
-         VersatUnitWrite(TOP_sha_State_s_6_reg_addr,0,initialStateValues[6]);
-         VersatUnitWrite(TOP_sha_State_s_7_reg_addr,0,initialStateValues[7]);
-      }
-
-      in += 64;
-      inlen -= 64;
-   }
-
-   // Note that at the end of this function the accelerator still needs one last run, since the accelerator contains valid data inside.
-   // We do not do the run now because it is possible that this function gets called again before ending the algorithm
-
-   return inlen;
-}
-
-void VersatSHA(uint8_t *out, const uint8_t *in, size_t inlen) {
-   uint8_t padded[128];
+// Pads the last partial block of the message and appends its length in bits. Returns the number of padded blocks, 1 or 2
+static size_t PadLastBlock(uint8_t* padded,const uint8_t* in,size_t inlen){
    uint64_t bytes = inlen;
 
-   // This is the function that handles the majority of the input
-   versat_crypto_hashblocks_sha256(in, inlen);
-
-   // The remaining code handles the padding of the last block
    in += inlen;
    inlen &= 63;
    in -= inlen;
 
+   size_t size = (inlen < 56) ? 64 : 128;
+
    for (size_t i = 0; i < inlen; ++i) {
       padded[i] = in[i];
    }
    padded[inlen] = 0x80;
+   for (size_t i = inlen + 1; i < size - 8; ++i) {
+      padded[i] = 0;
+   }
+
+   padded[size - 8] = (uint8_t) (bytes >> 53);
+   padded[size - 7] = (uint8_t) (bytes >> 45);
+   padded[size - 6] = (uint8_t) (bytes >> 37);
+   padded[size - 5] = (uint8_t) (bytes >> 29);
+   padded[size - 4] = (uint8_t) (bytes >> 21);
+   padded[size - 3] = (uint8_t) (bytes >> 13);
+   padded[size - 2] = (uint8_t) (bytes >> 5);
+   padded[size - 1] = (uint8_t) (bytes << 3);
+
+   return size / 64;
+}
 
-   if (inlen < 56) {
-      for (size_t i = inlen + 1; i < 56; ++i) {
-         padded[i] = 0;
-      
-    }  padded[56] = (uint8_t) (bytes >> 53);
-      padded[57] = (uint8_t) (bytes >> 45);
-      padded[58] = (uint8_t) (bytes >> 37);
-      padded[59] = (uint8_t) (bytes >> 29);
-      padded[60] = (uint8_t) (bytes >> 21);
-      padded[61] = (uint8_t) (bytes >> 13);
-      padded[62] = (uint8_t) (bytes >> 5);
-      padded[63] = (uint8_t) (bytes << 3);
-      versat_crypto_hashblocks_sha256(padded, 64);
-   } else {
-      for (size_t i = inlen + 1; i < 120; ++i) {
-         padded[i] = 0;
-      }
-      padded[120] = (uint8_t) (bytes >> 53);
-      padded[121] = (uint8_t) (bytes >> 45);
-      padded[122] = (uint8_t) (bytes >> 37);
-      padded[123] = (uint8_t) (bytes >> 29);
-      padded[124] = (uint8_t) (bytes >> 21);
-      padded[125] = (uint8_t) (bytes >> 13);
-      padded[126] = (uint8_t) (bytes >> 5);
-      padded[127] = (uint8_t) (bytes << 3);
-      versat_crypto_hashblocks_sha256(padded, 128);
+// Each run loads a block while processing the one loaded by the previous run. The run after the last block flushes the valid data inside the accelerator
+static void ConfigureSHARun(VersatJob* job,int run){
+   VersatSHAJob* sha = (VersatSHAJob*) job->context;
+
+   size_t block = (size_t) run;
+   if(block < sha->blocks){
+      ACCEL_TOP_sha_MemRead_ext_addr = (iptr) &sha->in[block * 64];
+   } else if(run < job->runs - 1){
+      ACCEL_TOP_sha_MemRead_ext_addr = (iptr) &sha->padded[(block - sha->blocks) * 64];
+   }
+
+   if(run == 1){
+      // Only load state after doing the first run, since the first run is the one that loads valid data and only the following runs do the actual work.
+      // This means that the result of the first run is garbage and we only want to set the initial valid state when we gonna process actual valid data.
+      VersatUnitWrite(TOP_sha_State_s_0_reg_addr,0,initialStateValues[0]);
+      VersatUnitWrite(TOP_sha_State_s_1_reg_addr,0,initialStateValues[1]);
+      VersatUnitWrite(TOP_sha_State_s_2_reg_addr,0,initialStateValues[2]);
+      VersatUnitWrite(TOP_sha_State_s_3_reg_addr,0,initialStateValues[3]);
+      VersatUnitWrite(TOP_sha_State_s_4_reg_addr,0,initialStateValues[4]);
+      VersatUnitWrite(TOP_sha_State_s_5_reg_addr,0,initialStateValues[5]);
+      VersatUnitWrite(TOP_sha_State_s_6_reg_addr,0,initialStateValues[6]);
+      VersatUnitWrite(TOP_sha_State_s_7_reg_addr,0,initialStateValues[7]);
    }
+}
 
-   // At this point the accelerator still contains valid data inside.
-   // One last run to flush all the valid data and obtain the final state.
-   RunAccelerator(1);
+// Read the values from the state registers. It is the output of the SHA algorithm
+static void FinishSHA(VersatJob* job,int run){
+   VersatSHAJob* sha = (VersatSHAJob*) job->context;
+   uint8_t* out = sha->out;
 
-   // Read the values from the state registers. It is the output of the SHA algorithm
    store_bigendian_32(&out[0*4],(uint32_t) VersatUnitRead(TOP_sha_State_s_0_reg_addr,0));
    store_bigendian_32(&out[1*4],(uint32_t) VersatUnitRead(TOP_sha_State_s_1_reg_addr,0));
    store_bigendian_32(&out[2*4],(uint32_t) VersatUnitRead(TOP_sha_State_s_2_reg_addr,0));
@@ -156,6 +131,26 @@ void VersatSHA(uint8_t *out, const uint8_t *in, size_t inlen) {
    store_bigendian_32(&out[5*4],(uint32_t) VersatUnitRead(TOP_sha_State_s_5_reg_addr,0));
    store_bigendian_32(&out[6*4],(uint32_t) VersatUnitRead(TOP_sha_State_s_6_reg_addr,0));
    store_bigendian_32(&out[7*4],(uint32_t) VersatUnitRead(TOP_sha_State_s_7_reg_addr,0));
+}
+
+void VersatSHASubmit(VersatSHAJob* sha,uint8_t *out, const uint8_t *in, size_t inlen){
+   sha->out = out;
+   sha->in = in;
+   sha->blocks = inlen / 64;
+
+   size_t paddedBlocks = PadLastBlock(sha->padded,in,inlen);
 
-   runInitialized = false; // At the end of each run, reset the runInitialized flag, since we have finished this "SHA run"
-}
\ No newline at end of file
+   sha->job.configure = ConfigureSHARun;
+   sha->job.finish = FinishSHA;
+   sha->job.context = sha;
+   sha->job.runs = (int) (sha->blocks + paddedBlocks + 1);
+
+   VersatJobSubmit(&sha->job,VersatJobLane_SHA);
+}
+
+void VersatSHA(uint8_t *out, const uint8_t *in, size_t inlen) {
+   VersatSHAJob sha;
+
+   VersatSHASubmit(&sha,out,in,inlen);
+   VersatJobWait(&sha.job);
+}
@@ -0,0 +1,10 @@
+#include "versat_shadow.h"
+
+#include <string.h>
+
+iptr versatShadow[SHADOW_WORDS];
+uint32_t versatShadowValid[(SHADOW_WORDS + 31) / 32];
+
+void ShadowInvalidate(){
+   memset(versatShadowValid,0,sizeof(versatShadowValid));
+}
@@ -0,0 +1,48 @@
+#ifndef INCLUDED_VERSAT_SHADOW
+#define INCLUDED_VERSAT_SHADOW
+
+#include "stdint.h"
+
+#include "versat_accel.h"
+
+/** \file
+ * Keeps a copy in memory of configuration fields of the accelerator that the drivers change between runs.
+ * Every write to accelConfig is an uncached bus transaction, while most of the fields set before a run keep the value of the previous run.
+ * A field written with ShadowWrite is only written to the accelerator when its value changes.
+ * A field must either always be written with ShadowWrite, or ShadowInvalidate must be called after writing it directly.
+ */
+
+//! Number of configuration words covered by the shadow
+#define SHADOW_WORDS (sizeof(CryptoAlgosConfig) / sizeof(iptr))
+
+//! Last value written to each configuration word
+extern iptr versatShadow[SHADOW_WORDS];
+
+//! One bit per configuration word, set when versatShadow holds the value of the word in the accelerator
+extern uint32_t versatShadowValid[(SHADOW_WORDS + 31) / 32];
+
+/**
+ * \brief Writes a configuration field if its value changed since the last ShadowWrite
+ * \param field pointer to the field inside accelConfig
+ * \param value value to write
+ */
+static inline void ShadowWrite(iptr* field,iptr value){
+   int index = (int) (field - (iptr*) accelConfig);
+   uint32_t bit = 1u << (index & 31);
+
+   if((versatShadowValid[index >> 5] & bit) && versatShadow[index] == value){
+      return;
+   }
+
+   *field = value;
+   versatShadow[index] = value;
+   versatShadowValid[index >> 5] |= bit;
+}
+
+/**
+ * Needed after the accelerator is reset, after ActivateMergedAccelerator, or after a field that is written with ShadowWrite is written directly
+ * \brief Forgets every value, so that the next ShadowWrite of each field writes it
+ */
+void ShadowInvalidate();
+
+#endif // INCLUDED_VERSAT_SHADOW
@@ -0,0 +1,199 @@
+#include "versat_crypto.h"
+
+#include "versat_accel.h"
+
+#include <stdbool.h>
+
+#include "unitConfiguration.h"
+
+#include "int32_sort.h"
+#include "uint64_sort.h"
+
+// SortStage handles compare-exchange distances of up to 32 elements, larger distances are done in software
+#define MAX_UNIT_LG_DIST 5
+
+// Words streamed per run. Sequences are split in at least MIN_CHUNKS chunks, so that a pass can start fetching
+// its first chunks while the previous pass is still writing its last ones
+#define MAX_CHUNK_WORDS 1024
+#define MIN_CHUNKS 4
+
+// Smaller sequences are sorted in software, the accelerator would spend most of the time starting runs
+#define MIN_ELEMENTS 256
+
+// Largest sequence that the offset and dirMask configurations can index
+#define MAX_ELEMENTS (1 << 15)
+
+static SortConfig* sort = NULL;
+
+/**
+ * Only the pointer to the configuration needs to be set. The SortStage unit never lengthens a run, so it can stay configured while other algorithms use the accelerator.
+ * \brief Initializes Versat Sort
+ */
+static void InitVersatSort(){
+   CryptoAlgosConfig* config = (CryptoAlgosConfig*) accelConfig;
+   sort = &config->sort;
+
+   ConfigureSimpleVReadBare(&sort->input);
+   ConfigureSimpleVWriteBare(&sort->output);
+}
+
+/**
+ * Like the other units, the accelerator is one run ahead of the software. A chunk fetched in a run goes through the SortStage
+ * unit in the next run and is written back to memory in the run after that.
+ * \brief Configures and starts one accelerator run
+ * \param fetch chunk the VRead starts fetching, NULL to disable it
+ * \param write chunk where the result of the previous run is written, NULL to disable it
+ * \param words size of a chunk in words
+ * \param lgDist distance of the stage applied in this run
+ * \param dirMask block size of the bitonic step applied in this run
+ * \param offset index of the first element of the chunk processed in this run
+ */
+static void SortRun(uint32_t* fetch,uint32_t* write,int words,int lgDist,int dirMask,int offset){
+   if(fetch){
+      ConfigureSimpleVReadShallow(&sort->input,words,(int*) fetch);
+   } else {
+      sort->input.enableRead = 0;
+   }
+
+   sort->stage.lgDist = lgDist;
+   sort->stage.dirMask = dirMask;
+   sort->stage.offset = offset;
+
+   ConfigureSimpleVWriteShallow(&sort->output,words,(int*) write);
+   if(!write){
+      sort->output.enableWrite = 0;
+   }
+
+   EndAccelerator();
+   StartAccelerator();
+}
+
+/**
+ * Every pass goes over the whole sequence one chunk per run. Since chunks are written back two runs after being fetched,
+ * consecutive passes are chained without waiting, as long as there are at least three chunks.
+ * \brief Applies the stages of distance 2^(lgFirst) down to 1 of one bitonic step using the accelerator
+ * \param x the sequence, 32 bit aligned
+ * \param words size of the sequence in words
+ * \param chunkWords size of a chunk in words
+ * \param wordsPerElement 1 or 2
+ * \param lgFirst distance of the first stage
+ * \param dirMask block size of the bitonic step
+ */
+static void UnitStages(uint32_t* x,int words,int chunkWords,int wordsPerElement,int lgFirst,int dirMask){
+   int chunks = words / chunkWords;
+   int chunkElements = chunkWords / wordsPerElement;
+   int items = (lgFirst + 1) * chunks;
+
+   for(int i = 0; i < items + 2; i++){
+      // Item i is fetched, item i - 1 is processed and item i - 2 is written
+      uint32_t* fetch = (i < items) ? x + (i % chunks) * chunkWords : NULL;
+      uint32_t* write = (i >= 2) ? x + ((i - 2) % chunks) * chunkWords : NULL;
+
+      int lgDist = 0;
+      int offset = 0;
+      if(i >= 1 && i <= items){
+         lgDist = lgFirst - (i - 1) / chunks;
+         offset = ((i - 1) % chunks) * chunkElements;
+      }
+
+      SortRun(fetch,write,chunkWords,lgDist,dirMask,offset);
+   }
+
+   EndAccelerator();
+
+   sort->input.enableRead = 0;
+   sort->output.enableWrite = 0;
+}
+
+static int ChunkWords(int words){
+   int chunkWords = words / MIN_CHUNKS;
+   if(chunkWords > MAX_CHUNK_WORDS){
+      chunkWords = MAX_CHUNK_WORDS;
+   }
+   return chunkWords;
+}
+
+static bool IsPowerOfTwo(long long n){
+   return (n & (n - 1)) == 0;
+}
+
+// Compare-exchanges done in software do not branch on the values and the accelerator passes take the same time for any input
+void VersatSortU64(uint64_t* x,long long n){
+   if(n < MIN_ELEMENTS || n > MAX_ELEMENTS || !IsPowerOfTwo(n) || (((iptr) x) & 3)){
+      uint64_sort(x,n);
+      return;
+   }
+
+   VersatJobWaitAll();
+
+   if(!sort){
+      InitVersatSort();
+   }
+
+   int words = (int) n * 2;
+   int chunkWords = ChunkWords(words);
+   sort->stage.wide = 1;
+
+   for(long long k = 2; k <= n; k *= 2){
+      // Distances too large for the unit
+      for(long long p = k / 2; p > (1 << MAX_UNIT_LG_DIST); p /= 2){
+         for(long long i = 0; i < n; i++){
+            if(i & p){
+               continue;
+            }
+            if(i & k){
+               uint64_MINMAX(x[i + p],x[i]);
+            } else {
+               uint64_MINMAX(x[i],x[i + p]);
+            }
+         }
+      }
+
+      int lgFirst = 0;
+      while(lgFirst < MAX_UNIT_LG_DIST && (2LL << lgFirst) < k){
+         lgFirst += 1;
+      }
+
+      UnitStages((uint32_t*) x,words,chunkWords,2,lgFirst,(int) k);
+   }
+}
+
+void VersatSortI32(int32_t* x,long long n){
+   if(n < MIN_ELEMENTS || n > MAX_ELEMENTS || !IsPowerOfTwo(n)){
+      int32_sort(x,n);
+      return;
+   }
+
+   VersatJobWaitAll();
+
+   if(!sort){
+      InitVersatSort();
+   }
+
+   int words = (int) n;
+   int chunkWords = ChunkWords(words);
+   sort->stage.wide = 0;
+
+   for(long long k = 2; k <= n; k *= 2){
+      // Distances too large for the unit
+      for(long long p = k / 2; p > (1 << MAX_UNIT_LG_DIST); p /= 2){
+         for(long long i = 0; i < n; i++){
+            if(i & p){
+               continue;
+            }
+            if(i & k){
+               int32_MINMAX(x[i + p],x[i]);
+            } else {
+               int32_MINMAX(x[i],x[i + p]);
+            }
+         }
+      }
+
+      int lgFirst = 0;
+      while(lgFirst < MAX_UNIT_LG_DIST && (2LL << lgFirst) < k){
+         lgFirst += 1;
+      }
+
+      UnitStages((uint32_t*) x,words,chunkWords,1,lgFirst,(int) k);
+   }
+}
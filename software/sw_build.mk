@@ -38,6 +38,31 @@ TEMPLATE_LDS=src/$@.lds
 
 IOB_SOC_OPENCRYPTOHW_INCLUDES=-I. -Isrc -Isrc/crypto/McEliece -Isrc/crypto/McEliece/common
 
+# Compile time options of the firmware sources
+IOB_SOC_OPENCRYPTOHW_DEFINES=
+
+# Classic McEliece parameter set: MCELIECE348864, MCELIECE460896, MCELIECE6688128 or MCELIECE8192128
+MCELIECE_PARAMETER_SET ?= MCELIECE348864
+IOB_SOC_OPENCRYPTOHW_DEFINES+=-DMCELIECE_PARAMETER_SET=$(MCELIECE_PARAMETER_SET)
+
+# Number of McEliece key generations timed against the software implementation, 0 skips the benchmark
+MCELIECE_BENCHMARK ?= 0
+ifneq ($(MCELIECE_BENCHMARK),0)
+IOB_SOC_OPENCRYPTOHW_DEFINES+=-DMCELIECE_BENCHMARK=$(MCELIECE_BENCHMARK)
+endif
+
+# Number of timed iterations of each SHA and AES input size, 0 skips the benchmark
+CRYPTO_BENCHMARK ?= 0
+ifneq ($(CRYPTO_BENCHMARK),0)
+IOB_SOC_OPENCRYPTOHW_DEFINES+=-DCRYPTO_BENCHMARK=$(CRYPTO_BENCHMARK)
+endif
+
+# Number of timed iterations of each size of the SHA and AES length sweep, 0 skips the sweep
+SWEEP_BENCHMARK ?= 0
+ifneq ($(SWEEP_BENCHMARK),0)
+IOB_SOC_OPENCRYPTOHW_DEFINES+=-DSWEEP_BENCHMARK=$(SWEEP_BENCHMARK)
+endif
+
 IOB_SOC_OPENCRYPTOHW_LFLAGS=-Wl,-Bstatic,-T,$(TEMPLATE_LDS),--strip-debug
 
 # FIRMWARE SOURCES
@@ -47,8 +72,13 @@ IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/printf.c
 
 IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_aes.c
 IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_sha.c
+IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_jobs.c
+IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_shadow.c
+IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_sequence.c
+IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_dispatch.c
 IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/crypto/aes.c
 IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/crypto_common_tests.c
+IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/crypto_benchmark.c
 
 ifeq ($(SIMULATION),1)
 IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/crypto_simulation_tests.c
@@ -57,8 +87,25 @@ IOB_SOC_OPENCRYPTOHW_FW_SRC+=$(wildcard src/crypto/McEliece/common/sha2.c)
 else
 IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/crypto_embedded_tests.c
 IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_mceliece.c
+IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_genpoly.c
+IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_root.c
+IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_keccak.c
+IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_benes.c
+IOB_SOC_OPENCRYPTOHW_FW_SRC+=src/versat_sort.c
 IOB_SOC_OPENCRYPTOHW_FW_SRC+=$(wildcard src/crypto/McEliece/*.c)
 IOB_SOC_OPENCRYPTOHW_FW_SRC+=$(wildcard src/crypto/McEliece/common/*.c)
+# SHAKE256 used by McEliece runs on the Keccak unit
+IOB_SOC_OPENCRYPTOHW_DEFINES+=-DVERSAT_KECCAK
+# Gaussian elimination of the McEliece irreducible polynomial runs on the Genpoly unit
+IOB_SOC_OPENCRYPTOHW_DEFINES+=-DVERSAT_GENPOLY
+# Evaluation of polynomials at the support of McEliece runs on the HornerEval unit
+IOB_SOC_OPENCRYPTOHW_DEFINES+=-DVERSAT_ROOT
+# Support generation of McEliece decryption runs on the BenesLayer unit
+IOB_SOC_OPENCRYPTOHW_DEFINES+=-DVERSAT_BENES
+# Sorts used to compute the control bits run on the Sort unit
+IOB_SOC_OPENCRYPTOHW_DEFINES+=-DVERSAT_SORT
+# The NIST KAT random generator encrypts its counter blocks on the AES unit
+IOB_SOC_OPENCRYPTOHW_DEFINES+=-DVERSAT_DRBG
 endif
 
 # PERIPHERAL SOURCES
@@ -74,7 +121,7 @@ IOB_SOC_OPENCRYPTOHW_BOOT_SRC+=$(filter-out %_emul.c, $(wildcard src/iob*cache*.
 build_iob_soc_opencryptohw_software: iob_soc_opencryptohw_firmware iob_soc_opencryptohw_boot
 
 iob_soc_opencryptohw_firmware:
-	make $@.elf INCLUDES="$(IOB_SOC_OPENCRYPTOHW_INCLUDES)" LFLAGS="$(IOB_SOC_OPENCRYPTOHW_LFLAGS) -Wl,-Map,$@.map" SRC="$(IOB_SOC_OPENCRYPTOHW_FW_SRC)" TEMPLATE_LDS="$(TEMPLATE_LDS)"
+	make $@.elf INCLUDES="$(IOB_SOC_OPENCRYPTOHW_INCLUDES) $(IOB_SOC_OPENCRYPTOHW_DEFINES)" LFLAGS="$(IOB_SOC_OPENCRYPTOHW_LFLAGS) -Wl,-Map,$@.map" SRC="$(IOB_SOC_OPENCRYPTOHW_FW_SRC)" TEMPLATE_LDS="$(TEMPLATE_LDS)"
 
 iob_soc_opencryptohw_boot:
 	make $@.elf INCLUDES="$(IOB_SOC_OPENCRYPTOHW_INCLUDES)" LFLAGS="$(IOB_SOC_OPENCRYPTOHW_LFLAGS) -Wl,-Map,$@.map" SRC="$(IOB_SOC_OPENCRYPTOHW_BOOT_SRC)" TEMPLATE_LDS="$(TEMPLATE_LDS)"
@@ -91,12 +138,17 @@ iob_soc_opencryptohw_boot:
 EMUL_SRC+=src/iob_soc_opencryptohw_firmware.c
 EMUL_SRC+=src/printf.c
 
-EMUL_INCLUDES = $(IOB_SOC_OPENCRYPTOHW_INCLUDES)
+EMUL_INCLUDES = $(IOB_SOC_OPENCRYPTOHW_INCLUDES) $(IOB_SOC_OPENCRYPTOHW_DEFINES)
 
 EMUL_SRC+=src/versat_aes.c
 EMUL_SRC+=src/versat_sha.c
+EMUL_SRC+=src/versat_jobs.c
+EMUL_SRC+=src/versat_shadow.c
+EMUL_SRC+=src/versat_sequence.c
+EMUL_SRC+=src/versat_dispatch.c
 EMUL_SRC+=src/crypto/aes.c
 EMUL_SRC+=src/crypto_common_tests.c
+EMUL_SRC+=src/crypto_benchmark.c
 
 ifeq ($(SIMULATION),1)
 EMUL_SRC+=src/crypto_simulation_tests.c
@@ -105,6 +157,11 @@ EMUL_SRC+=$(wildcard src/crypto/McEliece/common/sha2.c)
 else
 EMUL_SRC+=src/crypto_embedded_tests.c
 EMUL_SRC+=src/versat_mceliece.c
+EMUL_SRC+=src/versat_genpoly.c
+EMUL_SRC+=src/versat_root.c
+EMUL_SRC+=src/versat_keccak.c
+EMUL_SRC+=src/versat_benes.c
+EMUL_SRC+=src/versat_sort.c
 EMUL_SRC+=$(wildcard src/crypto/McEliece/*.c)
 EMUL_SRC+=$(wildcard src/crypto/McEliece/common/*.c)
 endif